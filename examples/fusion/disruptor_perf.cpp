@@ -0,0 +1,361 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ku/fusion/disruptor/ring_buffer.hpp>
+#include <ku/fusion/disruptor/waiting.hpp>
+#include <ku/fusion/disruptor/topology.hpp>
+#include <ku/fusion/util.hpp>
+
+// ======================================================================================
+// disruptor_perf runs the LMAX performance test topologies, on the disruptor and on
+// std::queue with mutex as baseline, reporting ops/sec and a latency histogram:
+//   1p1c: unicast, P -> C
+//   pipeline: P -> C1 -> C2 -> C3
+//   multicast: P -> C1, C2, C3
+//   diamond: P -> C1, C2 -> C3
+//   3p1c: P1, P2, P3 -> C
+// Latency is from publishing to the last consumer handling it, e.g.
+//   disruptor_perf [scenario = all] [waiting = yield] [ring_size = 1024] [count = 1000000]
+// waiting is one of busy_spin, yield, phased, futex, condition, timeout.
+// ======================================================================================
+using namespace ku::fusion::disruptor;
+
+namespace {
+
+struct Event
+{
+  int64_t value, a, b;
+  int64_t stamp;
+};
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Latencies in log2 buckets of nanoseconds
+class Histogram
+{
+public:
+  Histogram() : count_(0), sum_(0) { std::memset(buckets_, 0, sizeof(buckets_)); }
+
+  void add(int64_t ns)
+  {
+    uint64_t const n = ns > 0 ? ns : 0;
+    ++buckets_[n ? 64 - __builtin_clzll(n) : 0];
+    ++count_;
+    sum_ += n;
+  }
+
+  void add(Histogram const& h)
+  {
+    for (int n = 0; n < 65; ++n)
+      buckets_[n] += h.buckets_[n];
+    count_ += h.count_;
+    sum_ += h.sum_;
+  }
+
+  // Upper bound of the bucket holding the percentile
+  uint64_t percentile(double p) const
+  {
+    uint64_t const target = count_ * p / 100;
+    uint64_t seen = 0;
+    for (int n = 0; n < 65; ++n) {
+      if ((seen += buckets_[n]) > target)
+        return n ? (n < 64 ? (1ULL << n) - 1 : ~0ULL) : 0;
+    }
+    return 0;
+  }
+
+  void print() const
+  {
+    if (!count_)
+      return;
+    std::cout << "    mean " << sum_ / count_ << " ns, p50 <= " << percentile(50)
+      << " ns, p99 <= " << percentile(99) << " ns, p99.9 <= " << percentile(99.9) << " ns" << std::endl;
+    for (int n = 0; n < 65; ++n) {
+      if (buckets_[n])
+        std::cout << "    < " << std::setw(12) << (n < 64 ? 1ULL << n : ~0ULL) << " ns: "
+          << std::setw(10) << buckets_[n] << std::endl;
+    }
+  }
+
+private:
+  uint64_t buckets_[65];
+  uint64_t count_, sum_;
+};
+
+void report(char const* scenario, char const* impl, size_t count, int64_t ns, Histogram const& histogram)
+{
+  std::cout << std::setw(10) << scenario << std::setw(12) << impl << ": "
+    << std::setw(12) << uint64_t(count * 1e9 / (ns ? ns : 1)) << " ops/sec" << std::endl;
+  histogram.print();
+}
+
+struct Params
+{
+  size_t ring_size, count;
+};
+
+//
+/// Disruptor ///
+struct Record
+{
+  void operator()(Event& event, size_t, bool) { histogram.add(now_ns() - event.stamp); }
+  Histogram& histogram;
+};
+
+
+struct SumRecord
+{
+  void operator()(Event& event, size_t, bool)
+  {
+    sum += event.a + event.b;
+    histogram.add(now_ns() - event.stamp);
+  }
+  int64_t sum;
+  Histogram& histogram;
+};
+
+struct Double
+{
+  void operator()(Event& event, size_t, bool) { event.a = event.value * 2; }
+};
+
+struct Increase
+{
+  void operator()(Event& event, size_t, bool) { event.b = event.a + 1; }
+};
+
+// Publishes count events on producers threads, returns ns till the leaves have all
+template <typename Buffer>
+int64_t drive(Buffer& buffer, Topology<Buffer>& topology, size_t producers, size_t count)
+{
+  topology.start();
+  int64_t const start = now_ns();
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&]() {
+      for (size_t n = 0; n < count / producers; ++n) {
+        size_t seq = buffer.claim_next();
+        Event& event = buffer[seq];
+        event.value = n;
+        event.stamp = now_ns();
+        buffer.publish(seq);
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  size_t const last = buffer.cursor();
+  for (auto seq : topology.leaves()) {
+    while (seq->get() < last)
+      std::this_thread::yield();
+  }
+  int64_t const elapsed = now_ns() - start;
+
+  topology.halt();
+  topology.join();
+  return elapsed;
+}
+
+template <typename Waiting>
+void disruptor(std::string const& scenario, Params const& params)
+{
+  using Buffer = RingBuffer<Event, Waiting>;
+  Histogram histogram;
+  size_t const count = params.count;
+  if (scenario == "1p1c") {
+    Buffer buffer(params.ring_size);
+    Topology<Buffer> topology(buffer);
+    topology.handle_with(Record{ histogram });
+    report("1p1c", "disruptor", count, drive(buffer, topology, 1, count), histogram);
+  } else if (scenario == "pipeline") {
+    Buffer buffer(params.ring_size);
+    Topology<Buffer> topology(buffer);
+    topology.handle_with(Double()).then(Increase()).then(SumRecord{ 0, histogram });
+    report("pipeline", "disruptor", count, drive(buffer, topology, 1, count), histogram);
+  } else if (scenario == "multicast") {
+    Buffer buffer(params.ring_size);
+    Topology<Buffer> topology(buffer);
+    Histogram h1, h2;
+    topology.handle_with(Record{ histogram }, Record{ h1 }, Record{ h2 });
+    int64_t ns = drive(buffer, topology, 1, count);
+    histogram.add(h1);
+    histogram.add(h2);
+    report("multicast", "disruptor", count, ns, histogram);
+  } else if (scenario == "diamond") {
+    Buffer buffer(params.ring_size);
+    Topology<Buffer> topology(buffer);
+    topology.handle_with(Double(), [](Event& event, size_t, bool) { event.b = event.value + 1; })
+      .then(SumRecord{ 0, histogram });
+    report("diamond", "disruptor", count, drive(buffer, topology, 1, count), histogram);
+  } else if (scenario == "3p1c") {
+    using MultiBuffer = RingBuffer<Event, Waiting, MultiClaimer>;
+    MultiBuffer buffer(params.ring_size);
+    Topology<MultiBuffer> topology(buffer);
+    topology.handle_with(Record{ histogram });
+    report("3p1c", "disruptor", count / 3 * 3, drive(buffer, topology, 3, count), histogram);
+  }
+}
+
+//
+/// Baseline ///
+class Queue
+{
+public:
+  Queue(size_t capacity) : capacity_(capacity) { }
+
+  void push(Event const& event)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (queue_.size() >= capacity_)
+      not_full_.wait(lock);
+    queue_.push(event);
+    not_empty_.notify_one();
+  }
+
+  Event pop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (queue_.empty())
+      not_empty_.wait(lock);
+    Event event = queue_.front();
+    queue_.pop();
+    not_full_.notify_one();
+    return event;
+  }
+
+private:
+  size_t const capacity_;
+  std::queue<Event> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+};
+
+void produce(std::vector<Queue*> const& queues, size_t count)
+{
+  for (size_t n = 0; n < count; ++n) {
+    Event event = { int64_t(n), 0, 0, now_ns() };
+    for (auto q : queues)
+      q->push(event);
+  }
+}
+
+void baseline(std::string const& scenario, Params const& params)
+{
+  Histogram histogram;
+  size_t const count = params.count, size = params.ring_size;
+  int64_t const start = now_ns();
+  std::vector<std::thread> threads;
+  Queue q1(size), q2(size), q3(size), q4(size);
+  Histogram h1, h2;
+  auto record = [&](Queue& in, Histogram& h, size_t n) {
+    while (n--)
+      h.add(now_ns() - in.pop().stamp);
+  };
+  auto stage = [&](Queue& in, Queue& out, size_t n) {
+    while (n--) {
+      Event event = in.pop();
+      event.a = event.value * 2;
+      out.push(event);
+    }
+  };
+
+  if (scenario == "1p1c") {
+    threads.emplace_back(record, std::ref(q1), std::ref(histogram), count);
+    produce({ &q1 }, count);
+  } else if (scenario == "pipeline") {
+    threads.emplace_back(stage, std::ref(q1), std::ref(q2), count);
+    threads.emplace_back(stage, std::ref(q2), std::ref(q3), count);
+    threads.emplace_back(record, std::ref(q3), std::ref(histogram), count);
+    produce({ &q1 }, count);
+  } else if (scenario == "multicast") {
+    threads.emplace_back(record, std::ref(q1), std::ref(histogram), count);
+    threads.emplace_back(record, std::ref(q2), std::ref(h1), count);
+    threads.emplace_back(record, std::ref(q3), std::ref(h2), count);
+    produce({ &q1, &q2, &q3 }, count);
+  } else if (scenario == "diamond") {
+    threads.emplace_back(stage, std::ref(q1), std::ref(q3), count);
+    threads.emplace_back(stage, std::ref(q2), std::ref(q4), count);
+    threads.emplace_back([&]() {
+      for (size_t n = 0; n < count; ++n) {
+        int64_t stamp = q3.pop().stamp;
+        q4.pop();
+        histogram.add(now_ns() - stamp);
+      }
+    });
+    produce({ &q1, &q2 }, count);
+  } else if (scenario == "3p1c") {
+    threads.emplace_back(record, std::ref(q1), std::ref(histogram), count / 3 * 3);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 3; ++p)
+      producers.emplace_back(produce, std::vector<Queue*>{ &q1 }, count / 3);
+    for (auto& t : producers)
+      t.join();
+  }
+  for (auto& t : threads)
+    t.join();
+  histogram.add(h1);
+  histogram.add(h2);
+  report(scenario.c_str(), "queue", scenario == "3p1c" ? count / 3 * 3 : count, now_ns() - start, histogram);
+}
+
+void run(std::string const& scenario, std::string const& waiting, Params const& params)
+{
+  if (waiting == "busy_spin")
+    disruptor<BusySpinWaiting>(scenario, params);
+  else if (waiting == "yield")
+    disruptor<YieldWaiting>(scenario, params);
+  else if (waiting == "phased")
+    disruptor<PhasedWaiting>(scenario, params);
+  else if (waiting == "futex")
+    disruptor<FutexWaiting>(scenario, params);
+  else if (waiting == "condition")
+    disruptor<ConditionWaiting>(scenario, params);
+  else
+    disruptor<TimeoutBlockingWaiting>(scenario, params);
+  baseline(scenario, params);
+}
+
+} // unamed namespace
+
+int main(int argc, char* argv[])
+{
+  static char const* scenarios[] = { "1p1c", "pipeline", "multicast", "diamond", "3p1c" };
+  static char const* waitings[] = { "busy_spin", "yield", "phased", "futex", "condition", "timeout" };
+
+  std::string scenario = argc > 1 ? argv[1] : "all";
+  std::string waiting = argc > 2 ? argv[2] : "yield";
+  Params params = { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1024,
+                    argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1000000 };
+  bool valid = scenario == "all" && params.ring_size && params.count >= 3;
+  for (auto s : scenarios)
+    valid |= scenario == s && params.ring_size && params.count >= 3;
+  bool valid_waiting = false;
+  for (auto w : waitings)
+    valid_waiting |= waiting == w;
+  if (!valid || !valid_waiting) {
+    std::cout << "Usage: disruptor_perf [all|1p1c|pipeline|multicast|diamond|3p1c] "
+      "[busy_spin|yield|phased|futex|condition|timeout] [ring_size] [count]" << std::endl;
+    return 1;
+  }
+
+  // RingBuffer rounds up to a power of two, the queue baseline runs at the same capacity
+  params.ring_size = ku::fusion::util::ceiling_pow_of_two(params.ring_size);
+  std::cout << "waiting: " << waiting << ", ring size: " << params.ring_size
+    << ", events: " << params.count << std::endl;
+  for (auto s : scenarios) {
+    if (scenario == "all" || scenario == s)
+      run(s, waiting, params);
+  }
+}
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <future>
 #include <ku/fusion/endpoint.hpp>
@@ -34,19 +35,20 @@ public:
 int main(int argc, char* argv[])
 {
   if (argc < 2) {
-    std::cout << "Usage: echo_server endpoint" << std::endl;
+    std::cout << "Usage: echo_server endpoint [loops]" << std::endl;
     exit(0);
   }
 
   try {
     Endpoint ep(argv[1]);
     SocketEndpoint local_endpoint(ep);
-    tcp::Server<EchoHandler> server(local_endpoint);
+    size_t loops = argc > 2 ? std::atoi(argv[2]) : 1;
+    tcp::Server<EchoHandler> server(local_endpoint, loops > 0 ? loops : 1);
     // auto fut = std::async(std::ref(server)); TODO async in gcc 4.6 seems broken
     std::thread t(std::ref(server));
     std::cout << "Server running, press enter to exit." << std::endl;
     std::cin.ignore();
-    server.stop(); // TODO if poller has infinite timeout, this won't work
+    server.stop();
     std::cout << "Server stopped, exiting program." << std::endl;
     t.join();
   } catch (std::system_error const& ec) {
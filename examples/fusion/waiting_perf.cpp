@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <ku/fusion/disruptor/ring_buffer.hpp>
+#include <ku/fusion/disruptor/waiting.hpp>
+
+// ======================================================================================
+// waiting_perf shows latency against consumer cpu of the disruptor waiting strategies.
+// The producer publishes timestamped events with a gap between them, the consumer
+// records how late it sees each one, and how much cpu it burns meanwhile, e.g.
+//   waiting_perf [count = 100000] [gap_us = 10]
+// ======================================================================================
+using namespace ku::fusion::disruptor;
+
+struct Event
+{
+  int64_t stamp;
+};
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t thread_cpu_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+template <typename Waiting>
+void run(char const* name, size_t count, int64_t gap_ns)
+{
+  RingBuffer<Event, Waiting> buffer(1024);
+  size_t const first = buffer.cursor() + 1;
+  Sequence consumed(buffer.cursor());
+  buffer.set_gatings({&consumed});
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(count);
+  int64_t cpu = 0;
+  std::thread consumer([&]() {
+    int64_t const cpu_start = thread_cpu_ns();
+    for (size_t seq = first; seq < first + count; ) {
+      size_t available = buffer.wait_for(seq);
+      int64_t const seen = now_ns();
+      for (; seq <= available; ++seq)
+        latencies.push_back(seen - buffer[seq].stamp);
+      consumed.set(available);
+    }
+    cpu = thread_cpu_ns() - cpu_start;
+  });
+
+  int64_t const start = now_ns();
+  for (size_t n = 0; n < count; ++n) {
+    for (int64_t until = now_ns() + gap_ns; now_ns() < until; ) ;
+    size_t seq = buffer.claim_next();
+    buffer[seq].stamp = now_ns();
+    buffer.publish(seq);
+  }
+  consumer.join();
+  int64_t const wall = now_ns() - start;
+
+  std::sort(latencies.begin(), latencies.end());
+  int64_t sum = 0;
+  for (auto l : latencies)
+    sum += l;
+  std::cout << std::setw(24) << name
+    << " avg: " << std::setw(8) << sum / int64_t(count) << " ns"
+    << "  p50: " << std::setw(8) << latencies[count / 2] << " ns"
+    << "  p99: " << std::setw(8) << latencies[count * 99 / 100] << " ns"
+    << "  consumer cpu: " << std::setw(5) << std::fixed << std::setprecision(1)
+    << 100.0 * cpu / wall << "%" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t const count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  int64_t const gap_ns = (argc > 2 ? std::atol(argv[2]) : 10) * 1000;
+  if (!count) {
+    std::cout << "Usage: waiting_perf [count] [gap_us]" << std::endl;
+    return 1;
+  }
+
+  run<BusySpinWaiting>("BusySpinWaiting", count, gap_ns);
+  run<YieldWaiting>("YieldWaiting", count, gap_ns);
+  run<PhasedWaiting>("PhasedWaiting", count, gap_ns);
+  run<FutexWaiting>("FutexWaiting", count, gap_ns);
+  run<ConditionWaiting>("ConditionWaiting", count, gap_ns);
+  run<TimeoutBlockingWaiting>("TimeoutBlockingWaiting", count, gap_ns);
+}
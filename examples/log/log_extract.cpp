@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <ku/log/log_level.hpp>
+#include <ku/log/log_index.hpp>
+#include <ku/log/lz.hpp>
+#include <ku/log/util.hpp>
+
+// ======================================================================================
+// log_extract prints the messages of a FileSink log collected in a time window, using
+// the sidecar index to seek, e.g.
+//   log_extract trade_20111208_4242.log "10:31:05" "10:31:07" Warn
+// Times without date take the date of the first message in the log. Logs written through
+// a CompressSink are decompressed frame by frame.
+// ======================================================================================
+using namespace ku::log;
+
+namespace {
+
+size_t const TimeSize = 29; // "YYYY-MM-DD HH:MM:SS.nnnnnnnnn"
+size_t const LevelSize = 7; // to_log() output
+
+bool parse_arg_time(char const* arg, char const* log_data, size_t log_size, uint64_t& time)
+{
+  if (util::parse_time(arg, time))
+    return true;
+  if (log_size < 11)
+    return false;
+  std::string with_date(log_data, 11); // "YYYY-MM-DD "
+  return util::parse_time(with_date.append(arg).c_str(), time);
+}
+
+// Prints lines in [begin, end] text time at or above level, continuation lines of a
+// multi-line message go with the message
+void print_lines(char const* p, size_t size, std::string const& begin, std::string const& end,
+                 LogLevel min_level)
+{
+  char const* const last = p + size;
+  bool printing = false;
+  while (p < last) {
+    char const* eol = static_cast<char const*>(std::memchr(p, '\n', last - p));
+    char const* next = eol ? eol + 1 : last;
+    LogLevel level;
+    if (size_t(next - p) > TimeSize + LevelSize && p[4] == '-' && p[TimeSize] == ' '
+        && to_log_level(p + TimeSize, LevelSize, level)) {
+      printing = level >= min_level
+                 && std::memcmp(p, begin.data(), TimeSize) >= 0
+                 && std::memcmp(p, end.data(), TimeSize) <= 0;
+    }
+    if (printing)
+      std::cout.write(p, next - p);
+    p = next;
+  }
+}
+
+// Decompresses the frames of a block, skipping to the next valid frame past corruption
+void inflate(char const* p, size_t size, std::string& out)
+{
+  out.clear();
+  char const* const last = p + size;
+  while (p < last) {
+    size_t n = lz::decode_frame(p, last - p, out);
+    p = n ? p + n : lz::find_frame(p + 1, last - p - 1);
+  }
+}
+
+} // unamed namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 4) {
+    std::cout << "Usage: log_extract log_file begin_time end_time [min_level]" << std::endl;
+    return 1;
+  }
+
+  try {
+    IndexReader reader(argv[1]);
+    // A compressed log starts with a valid frame, only the one at offset 0 is decoded,
+    // the index finds the rest
+    std::string text;
+    bool const compressed = lz::decode_frame(reader.data(), reader.size(), text) != 0;
+    if (!compressed)
+      text.assign(reader.data(), std::min(reader.size(), size_t(11)));
+    uint64_t begin_time, end_time;
+    if (!parse_arg_time(argv[2], text.data(), text.size(), begin_time)
+        || !parse_arg_time(argv[3], text.data(), text.size(), end_time)) {
+      std::cout << "Times are \"YYYY-MM-DD HH:MM:SS[.fraction]\" or \"HH:MM:SS[.fraction]\""
+        << std::endl;
+      return 1;
+    }
+    LogLevel min_level = LogLevel::Debug;
+    if (argc > 4 && !to_log_level(argv[4], std::strlen(argv[4]), min_level)) {
+      std::cout << "Unknown log level " << argv[4] << std::endl;
+      return 1;
+    }
+
+    // Lines are compared in text, which orders the same as time for fixed width format
+    char buf[32];
+    std::string begin(buf, util::format_time(buf, begin_time));
+    std::string end(buf, util::format_time(buf, end_time));
+    uint32_t level_mask = ~((1u << static_cast<uint32_t>(min_level)) - 1);
+    reader.for_each_block(begin_time, end_time, level_mask, [&](char const* p, size_t size) {
+      if (compressed) {
+        inflate(p, size, text);
+        p = text.data();
+        size = text.size();
+      }
+      print_lines(p, size, begin, end, min_level);
+    });
+  } catch (std::system_error const& ec) {
+    std::cout << "log_extract error in " << ec.what() << std::endl;
+    return 1;
+  }
+}
@@ -5,6 +5,7 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <utility>
 
 namespace ku { namespace fusion { namespace util {
 
@@ -44,6 +45,15 @@ auto if_handle_error(T& t, Args&... args)
 template <typename... T> bool if_handle_error(T&...)
 { return false; } // Default: remove handler on error
 
+// if_on_timeout
+template <typename T, typename... Args>
+auto if_on_timeout(T& t, Args&... args)
+  -> decltype(std::declval<T>().on_timeout(args...))
+{ return t.on_timeout(args...); }
+
+template <typename... T> void if_on_timeout(T&...)
+{ }
+
 } } } // namespace ku::fusion::util
 
 
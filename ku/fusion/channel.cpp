@@ -20,6 +20,9 @@ void Channel::bind(char const* endpoint)
   case Protocol::Inproc:
     // TODO UserEventEndpoint
     break;
+  case Protocol::Shm:
+    // Channel carries no event type for a disruptor::ShmRingBuffer, use one directly
+    throw std::system_error(util::errc(EPROTONOSUPPORT), "Channel::bind");
   default:
     // TODO SocketEndpoint
     break;
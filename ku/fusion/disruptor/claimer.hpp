@@ -5,10 +5,48 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include "../telemetry.hpp"
 #include "sequence.hpp"
+#include "waiting.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
+namespace aux {
+
+// Idles with waiting until done(), counting the wait if any. False if stopped first.
+template <typename Done, typename Waiting>
+inline bool idle_until(Done done, Waiting& waiting, WaitStats& stats, WaitStop const& stop = WaitStop())
+{
+  if (done())
+    return true;
+  auto const start = WaitStats::Clock::now();
+  bool ready = false;
+  size_t count = 0;
+  while (!stop.stopped(++count)) {
+    waiting.idle(count);
+    if ((ready = done()))
+      break;
+  }
+  stats.record_wait(count, WaitStats::Clock::now() - start);
+  return ready;
+}
+
+} // namespace ku::fusion::disruptor::aux
+
+// =======================================================================================
+// Claimers hand out sequences to publishers and track what is published:
+//   Claimer: for a single publisher, publishing moves the cursor, no atomic RMW at all
+//   MultiClaimer: for any number of publishers, claiming is a fetch_add on the cursor,
+//     publishing flags the slot with the round of its sequence, so consumers find the
+//     highest contiguous published sequence even if publishers finish out of order
+// Claiming waits for the slowest of the gating sequences with waiting.idle(), see
+// waiting.hpp, and counts the waits in stats(). Gating is SequenceList, or SequenceTuple
+// for consumers known at compile time, see sequence_tuple.hpp.
+// =======================================================================================
 class Claimer
 {
 public:
@@ -16,20 +54,150 @@ public:
   ~Claimer() = default;
 
   size_t get() const { return claim_seq_.get(); }
-  bool has_available(size_t capacity, SequenceList const& seq_list);
-  size_t claim_next(SequenceList const& seq_list);
-  size_t claim_next(size_t incr, SequenceList const& seq_list);
+  // Consumers wait for cursor, then check highest_published()
+  Sequence const& cursor() const { return cursor_; }
+  template <typename Gating>
+  bool has_available(size_t capacity, Gating const& gating);
+
+  template <typename Gating, typename Waiting>
+  size_t claim_next(Gating const& gating, Waiting& waiting)
+  { return claim_next(1, gating, waiting); }
+
+  template <typename Gating, typename Waiting>
+  size_t claim_next(size_t incr, Gating const& gating, Waiting& waiting)
+  {
+    size_t const next_seq = claim_seq_.get_relaxed() + incr;
+    claim_seq_.set(next_seq);
+    wait_for_seq(next_seq, gating, waiting);
+    return next_seq;
+  }
+
+  // False if stopped before capacity is available
+  template <typename Gating, typename Waiting>
+  bool wait_for_capacity(size_t capacity, Gating const& gating, Waiting& waiting,
+                         WaitStop const& stop = WaitStop())
+  { return aux::idle_until([&]() { return has_available(capacity, gating); }, waiting, stats_, stop); }
 
-  void wait_for_capacity(size_t capacity, SequenceList const& seq_list);
+  WaitStats const& stats() const { return stats_; }
+
+  void publish(size_t seq) { cursor_.set(seq); }
+  void publish(size_t, size_t hi) { cursor_.set(hi); }
+  size_t highest_published(size_t, size_t available) const { return available; }
 
 private:
-  void wait_for_seq(size_t seq, SequenceList const& seq_list);
+  template <typename Gating, typename Waiting>
+  void wait_for_seq(size_t seq, Gating const& gating, Waiting& waiting)
+  {
+    size_t const wrap_point = seq - buf_size_;
+    // Our own cache, set after an acquiring read of the gating sequences
+    if (wrap_point > gating_seq_.get_relaxed()) {
+      size_t min_seq = gating.min_sequence(wrap_point);
+      stats_.record_occupancy(std::min(seq - min_seq, buf_size_));
+      if (wrap_point > min_seq)
+        aux::idle_until([&]() { return wrap_point <= (min_seq = gating.min_sequence(wrap_point)); },
+                        waiting, stats_);
+      gating_seq_.set(min_seq);
+    }
+  }
 
 private:
   size_t const buf_size_;
-  Sequence claim_seq_, gating_seq_;
+  Sequence claim_seq_, gating_seq_, cursor_;
+  WaitStats stats_;
+};
+
+class MultiClaimer
+{
+public:
+  MultiClaimer(size_t buf_size);
+  ~MultiClaimer() = default;
+
+  size_t get() const { return cursor_.get(); }
+  // Highest claimed, consumers wait for it, then check highest_published()
+  Sequence const& cursor() const { return cursor_; }
+  template <typename Gating>
+  bool has_available(size_t capacity, Gating const& gating);
+
+  template <typename Gating, typename Waiting>
+  size_t claim_next(Gating const& gating, Waiting& waiting)
+  { return claim_next(1, gating, waiting); }
+
+  template <typename Gating, typename Waiting>
+  size_t claim_next(size_t incr, Gating const& gating, Waiting& waiting)
+  {
+    size_t const next_seq = cursor_.fetch_add(incr) + incr;
+    size_t const wrap_point = next_seq - buf_size_;
+    if (wrap_point > gating_seq_.get()) {
+      size_t min_seq = gating.min_sequence(wrap_point);
+      stats_.record_occupancy(std::min(next_seq - min_seq, buf_size_));
+      if (wrap_point > min_seq)
+        aux::idle_until([&]() { return wrap_point <= (min_seq = gating.min_sequence(wrap_point)); },
+                        waiting, stats_);
+      gating_seq_.set(min_seq); // a cache, racing publishers may set it lower, that's safe
+    }
+    return next_seq;
+  }
+
+  // False if stopped before capacity is available
+  template <typename Gating, typename Waiting>
+  bool wait_for_capacity(size_t capacity, Gating const& gating, Waiting& waiting,
+                         WaitStop const& stop = WaitStop())
+  { return aux::idle_until([&]() { return has_available(capacity, gating); }, waiting, stats_, stop); }
+
+  WaitStats const& stats() const { return stats_; }
+
+  void publish(size_t seq) { available_[seq & mask_].store(seq >> shift_, std::memory_order_release); }
+  void publish(size_t lo, size_t hi)
+  {
+    for (size_t seq = lo; seq <= hi; ++seq)
+      publish(seq);
+  }
+
+  // Highest sequence published contiguously from lo up to available, lo - 1 if none
+  size_t highest_published(size_t lo, size_t available) const
+  {
+    for (size_t seq = lo; seq <= available; ++seq) {
+      if (available_[seq & mask_].load(std::memory_order_acquire) != seq >> shift_)
+        return seq - 1;
+    }
+    return available;
+  }
+
+private:
+  size_t const buf_size_, mask_;
+  unsigned const shift_;
+  Sequence cursor_, gating_seq_;
+  std::unique_ptr<std::atomic_size_t[]> available_; // round of the sequence last published in each slot
+  WaitStats stats_;
 };
 
+template <typename Gating>
+bool Claimer::has_available(size_t capacity, Gating const& gating)
+{
+  assert(capacity > 0 && capacity <= buf_size_);
+
+  size_t const wrap_point = claim_seq_.get_relaxed() + capacity - buf_size_;
+  if (wrap_point > gating_seq_.get_relaxed()) {
+    size_t const min_seq = gating.min_sequence(wrap_point);
+    gating_seq_.set(min_seq);
+    return wrap_point <= min_seq;
+  }
+  return true;
+}
+
+template <typename Gating>
+bool MultiClaimer::has_available(size_t capacity, Gating const& gating)
+{
+  assert(capacity > 0 && capacity <= buf_size_);
+
+  size_t const wrap_point = cursor_.get() + capacity - buf_size_;
+  if (wrap_point > gating_seq_.get()) {
+    size_t const min_seq = gating.min_sequence(wrap_point);
+    gating_seq_.set(min_seq);
+    return wrap_point <= min_seq;
+  }
+  return true;
+}
 
 } } } // namespace ku::fusion::disruptor
 
@@ -5,15 +5,105 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+#include "../call_selector.hpp"
+#include "util.hpp"
 #include "sequence.hpp"
+#include "waiting.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
 class EventProcessor
 {
 public:
+  virtual ~EventProcessor() { }
+
+  // Processors hold cache line aligned Sequence
+  static void* operator new(size_t size) { return cache_aligned_new(size); }
+  static void operator delete(void* p) { cache_aligned_delete(p); }
+
   virtual Sequence& sequence() = 0;
+  // Processes events on the calling thread until halted
+  virtual void run() = 0;
+  virtual void halt() = 0;
 };
 
-} } } // namespace ku::fusion::disruptor
+// =======================================================================================
+// BatchEventProcessor hands every event available to handler, called as
+//   handler(Event& event, size_t seq, bool end_of_batch)
+// end_of_batch is set on the last event available at the moment, handlers do their
+// expensive work like flushing I/O there, and the processor sequence is moved once per
+// batch. Halting takes effect at batch boundary, and wakes the processor if waiting.
+// With set_timeout(), handlers having
+//   handler.on_timeout(size_t seq)
+// are called each time no event comes within the timeout, seq being the one waited for.
+// Deps is SequenceList set with set_dependencies(), or SequenceTuple given at
+// construction for dependencies fixed at compile time, see sequence_tuple.hpp.
+// =======================================================================================
+template <typename RingBuffer, typename Handler, typename Deps = SequenceList>
+class BatchEventProcessor final : public EventProcessor
+{
+public:
+  BatchEventProcessor(RingBuffer& buffer, Handler handler)
+    : buffer_(buffer), handler_(std::move(handler)), sequence_(buffer.cursor()), halted_(false)
+  {}
+  BatchEventProcessor(RingBuffer& buffer, Handler handler, Deps const& deps)
+    : buffer_(buffer), handler_(std::move(handler)), sequence_(buffer.cursor()), deps_(deps)
+    , halted_(false)
+  {}
+
+  // Sequences of processors to follow, the ring buffer cursor only if none
+  void set_dependencies(std::initializer_list<Sequence*> const& seqs) { deps_.initialize(seqs); }
+  void set_dependencies(std::vector<Sequence*> const& seqs) { deps_.initialize(seqs); }
+
+  // Zero, the default, never times out
+  void set_timeout(std::chrono::nanoseconds timeout) { timeout_ = timeout; }
+
+  virtual Sequence& sequence() { return sequence_; }
+  virtual void run();
+  virtual void halt();
+  bool halted() const { return halted_.load(std::memory_order_acquire); }
+
+  Handler& handler() { return handler_; }
 
+private:
+  RingBuffer& buffer_;
+  Handler handler_;
+  Sequence sequence_;
+  Deps deps_;
+  std::atomic<bool> halted_;
+  std::chrono::nanoseconds timeout_ = std::chrono::nanoseconds::zero();
+};
+
+
+template <typename RingBuffer, typename Handler, typename Deps>
+void BatchEventProcessor<RingBuffer, Handler, Deps>::run()
+{
+  size_t next_seq = sequence_.get_relaxed() + 1;
+  while (!halted()) {
+    WaitStop const stop = timeout_ == std::chrono::nanoseconds::zero()
+                        ? WaitStop(&halted_) : WaitStop(&halted_, WaitStop::Clock::now() + timeout_);
+    size_t const available = buffer_.wait_for(next_seq, deps_, stop);
+    if (available < next_seq) {
+      // halted, timed out, or claimed but not yet published
+      if (stop.timed() && !halted() && stop.expired())
+        util::if_on_timeout(handler_, next_seq);
+      continue;
+    }
+    for (; next_seq <= available; ++next_seq)
+      handler_(buffer_[next_seq], next_seq, next_seq == available);
+    sequence_.set(available);
+  }
+}
+
+template <typename RingBuffer, typename Handler, typename Deps>
+void BatchEventProcessor<RingBuffer, Handler, Deps>::halt()
+{
+  halted_.store(true, std::memory_order_release);
+  buffer_.waiting().notify_all();
+}
+
+} } } // namespace ku::fusion::disruptor
@@ -5,9 +5,24 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 
 namespace ku { namespace fusion { namespace disruptor {
 
+// =======================================================================================
+// EventPublisher writes events to their slots and publishes them. Translators build the
+// event in place, instead of copying one in:
+//   publisher.publish_event([](Event& event, size_t seq, Quote const& quote) { ... }, quote);
+// Batches claim N slots at once and publish the range with one cursor store:
+//   publisher.publish_events(packet.begin(), packet.end(),
+//                            [](Event& event, size_t seq, Update const& update) { ... });
+// Slots claimed are published even when translator throws, a claimed slot left
+// unpublished would stall the consumers, events in them are as translator left.
+// =======================================================================================
 template <typename RingBuffer>
 class EventPublisher
 {
@@ -21,21 +36,89 @@ public:
 
   void publish(EventType const& event);
 
+  // translator(EventType& event, size_t seq, args...)
+  template <typename Translator, typename... Args>
+  void publish_event(Translator&& translator, Args&&... args);
+
+  // translator(EventType& event, size_t seq, *it) for each in [begin, end), batches of
+  // up to ring buffer capacity. Iterator is a forward one, the range is counted once
+  // before it is read.
+  template <typename Iterator, typename Translator>
+  void publish_events(Iterator begin, Iterator end, Translator&& translator);
+
+  // translator(EventType& event, size_t seq, size_t n) for n in [0, count)
+  template <typename Translator>
+  void publish_events(size_t count, Translator&& translator);
+
 private:
   RingBuffer& buffer_;
 };
 
 
 template <typename RingBuffer>
-void EventPublisher::publish(EventType const& event)
+void EventPublisher<RingBuffer>::publish(EventType const& event)
 {
   size_t seq = buffer_.claim_next();
-  buffer_[seq] = event; // TODO this can be more generic with a translator
+  buffer_[seq] = event;
   // A properly implemented RingBuffer guarantees that publish(seq) is not re-ordered before
   // event is written to the slot, so "publish" has the "commit" semantic
   buffer_.publish(seq);
 }
 
+template <typename RingBuffer>
+template <typename Translator, typename... Args>
+void EventPublisher<RingBuffer>::publish_event(Translator&& translator, Args&&... args)
+{
+  size_t seq = buffer_.claim_next();
+  try {
+    translator(buffer_[seq], seq, std::forward<Args>(args)...);
+  } catch (...) {
+    buffer_.publish(seq);
+    throw;
+  }
+  buffer_.publish(seq);
+}
 
-} } } // namespace ku::fusion::disruptor
+template <typename RingBuffer>
+template <typename Iterator, typename Translator>
+void EventPublisher<RingBuffer>::publish_events(Iterator begin, Iterator end, Translator&& translator)
+{
+  static_assert(std::is_base_of<std::forward_iterator_tag,
+                                typename std::iterator_traits<Iterator>::iterator_category>::value,
+                "publish_events needs forward iterators");
+  for (size_t left = std::distance(begin, end); left; ) {
+    size_t const count = std::min(left, buffer_.capacity());
+    size_t const hi = buffer_.claim_next(count);
+    size_t const lo = hi - count + 1;
+    left -= count;
+    try {
+      for (size_t seq = lo; seq <= hi; ++seq, ++begin)
+        translator(buffer_[seq], seq, *begin);
+    } catch (...) {
+      buffer_.publish(lo, hi);
+      throw;
+    }
+    buffer_.publish(lo, hi);
+  }
+}
+
+template <typename RingBuffer>
+template <typename Translator>
+void EventPublisher<RingBuffer>::publish_events(size_t count, Translator&& translator)
+{
+  for (size_t n = 0; n < count; ) {
+    size_t const batch = std::min(count - n, buffer_.capacity());
+    size_t const hi = buffer_.claim_next(batch);
+    size_t const lo = hi - batch + 1;
+    try {
+      for (size_t seq = lo; seq <= hi; ++seq, ++n)
+        translator(buffer_[seq], seq, n);
+    } catch (...) {
+      buffer_.publish(lo, hi);
+      throw;
+    }
+    buffer_.publish(lo, hi);
+  }
+}
 
+} } } // namespace ku::fusion::disruptor
@@ -5,53 +5,119 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <algorithm>
 #include <initializer_list>
 #include <vector>
+#include "../telemetry.hpp"
 #include "util.hpp"
 #include "sequence.hpp"
 #include "claimer.hpp"
+#include "waiting.hpp"
+#include "storage.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
-template <typename Event, typename Waiting>
+// Claiming is Claimer for a single publisher, or MultiClaimer for many, see claimer.hpp.
+// Storage lays out the events, see storage.hpp.
+template <typename Event, typename Waiting, typename Claiming = Claimer, typename Storage = VectorStorage>
 class RingBuffer
 {
+  using Entries = typename Storage::template Entries<Event>;
+
 public:
-  using EventType Event;
+  using EventType = Event;
+  using WaitingType = Waiting;
+  using ClaimingType = Claiming;
+  using StorageType = Storage;
+  // Event& but with ColumnStorage
+  using Reference = typename Entries::reference;
+  using ConstReference = typename Entries::const_reference;
 
   RingBuffer(size_t size)
-    : mask_(next_pow_of_two(size) - 1), entries_(mask_ + 1)
-    , cursor_(capacity() - 1) // cursor starts from 1 slot before capacity to make wrapping easy, consider moving to Claimer
-    , claimer_(capacity())
+    : mask_(util::ceiling_pow_of_two(size) - 1), entries_(mask_ + 1)
+    , claimer_(capacity()) // cursor starts from 1 slot before capacity to make wrapping easy
   {}
 
   void set_gatings(std::initializer_list<Sequence*> const& seqs) { gating_seqs_.initialize(seqs); }
+  void set_gatings(std::vector<Sequence*> const& seqs) { gating_seqs_.initialize(seqs); }
+  // Consumers joining a live ring start after the cursor, leaving ones stop gating the
+  // publisher, neither blocks it
+  void add_gating(Sequence& seq);
+  bool remove_gating(Sequence& seq) { return gating_seqs_.remove(&seq); }
 
   size_t capacity() const { return entries_.size(); }
-  size_t cursor() const { return cursor_.get(); }
+  // Published with Claimer, claimed with MultiClaimer
+  size_t cursor() const { return claimer_.cursor().get(); }
 
-  Event& get(size_t seq) { return entries_[seq & mask_]; }
-  Event const& get(size_t seq) const { return entries_[seq & mask_]; }
-  Event& operator[] (size_t seq) { return get(seq); }
-  Event const& operator[] (size_t seq) const { return get(seq); }
+  Reference get(size_t seq) { return entries_[seq & mask_]; }
+  ConstReference get(size_t seq) const { return entries_[seq & mask_]; }
+  Reference operator[] (size_t seq) { return get(seq); }
+  ConstReference operator[] (size_t seq) const { return get(seq); }
 
-  size_t claim_next() { return claimer_.claim_next(gating_seqs_); }
-  size_t claim_next(size_t incr) { return claimer_.claim_next(incr, gating_seqs_); }
+  size_t claim_next() { return claimer_.claim_next(gating_seqs_, waiting_); }
+  size_t claim_next(size_t incr) { return claimer_.claim_next(incr, gating_seqs_, waiting_); }
   bool has_available(size_t capacity) { return claimer_.has_available(capacity, gating_seqs_); }
-  void publish(size_t seq) { cursor_.set(seq); waiting_.notify_all(); }
+  // False if stopped first, see WaitStop
+  bool wait_for_capacity(size_t capacity, WaitStop const& stop = WaitStop())
+  { return claimer_.wait_for_capacity(capacity, gating_seqs_, waiting_, stop); }
+  // Gated on consumers fixed at compile time instead, see sequence_tuple.hpp
+  template <typename Gating>
+  size_t claim_next(size_t incr, Gating const& gating) { return claimer_.claim_next(incr, gating, waiting_); }
+  template <typename Gating>
+  bool has_available(size_t capacity, Gating const& gating) { return claimer_.has_available(capacity, gating); }
+  template <typename Gating>
+  bool wait_for_capacity(size_t capacity, Gating const& gating, WaitStop const& stop = WaitStop())
+  { return claimer_.wait_for_capacity(capacity, gating, waiting_, stop); }
+  void publish(size_t seq) { claimer_.publish(seq); waiting_.notify_all(); }
+  // Publishes claimed [lo, hi] at once
+  void publish(size_t lo, size_t hi) { claimer_.publish(lo, hi); waiting_.notify_all(); }
 
-private:
-  void wait_for(size_t capacity) { claimer_.wait_for_capacity(capacity, gating_seqs_); }
+  // For consumers, waits until seq is published and processed by all of deps, returns
+  // the highest available sequence. It is lower than seq once stopped (see WaitStop), on
+  // timeout (see Waiting), or with MultiClaimer, when seq is claimed but not yet
+  // published, callers just retry.
+  template <typename Deps>
+  size_t wait_for(size_t seq, Deps const& deps, WaitStop const& stop = WaitStop())
+  { return claimer_.highest_published(seq, waiting_.wait_for(seq, claimer_.cursor(), deps, stop)); }
+  size_t wait_for(size_t seq) { return wait_for(seq, no_deps_); }
+
+  Waiting& waiting() { return waiting_; }
+
+  // For monitoring threads, reads the cursor and gating sequences only
+  RingTelemetry telemetry() const;
 
 private:
   size_t const mask_;
-  std::vector<Event> entries_;
-  Sequence cursor_;
-  SequenceList gating_seqs_;
-  Claimer claimer_;
+  Entries entries_;
+  SequenceList gating_seqs_, no_deps_;
+  Claiming claimer_;
   Waiting waiting_;
 };
 
 
+template <typename Event, typename Waiting, typename Claiming, typename Storage>
+void RingBuffer<Event, Waiting, Claiming, Storage>::add_gating(Sequence& seq)
+{
+  // Setting the cursor again once gating, the publisher may have wrapped past the 1st one
+  seq.set(cursor());
+  gating_seqs_.add(&seq);
+  seq.set(cursor());
+}
+
+template <typename Event, typename Waiting, typename Claiming, typename Storage>
+RingTelemetry RingBuffer<Event, Waiting, Claiming, Storage>::telemetry() const
+{
+  RingTelemetry telemetry = RingTelemetry();
+  size_t const cursor = this->cursor();
+  telemetry.capacity = capacity();
+  for (size_t seq : gating_seqs_.sequences()) {
+    telemetry.lags.push_back(cursor - seq);
+    telemetry.occupancy = std::max(telemetry.occupancy, cursor - seq);
+  }
+  telemetry.publisher = claimer_.stats().snapshot();
+  telemetry.publisher.max_occupancy = std::max(telemetry.publisher.max_occupancy, telemetry.occupancy);
+  return telemetry;
+}
+
 } } } // namespace ku::fusion::disruptor
 
@@ -0,0 +1,78 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include "sequence.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+namespace aux {
+
+inline Sequence const& sequence_of(Sequence const& seq) { return seq; }
+
+template <typename Processor>
+inline auto sequence_of(Processor& processor) -> decltype(processor.sequence())
+{ return processor.sequence(); }
+
+template <size_t N>
+struct min_of
+{
+  template <typename Tuple>
+  static size_t get(Tuple const& tuple)
+  {
+    size_t const head = min_of<N - 1>::get(tuple);
+    size_t const value = sequence_of(std::get<N - 1>(tuple)).get();
+    return value < head ? value : head;
+  }
+};
+
+template <>
+struct min_of<1>
+{
+  template <typename Tuple>
+  static size_t get(Tuple const& tuple) { return sequence_of(std::get<0>(tuple)).get(); }
+};
+
+} // namespace ku::fusion::disruptor::aux
+
+// =======================================================================================
+// SequenceTuple gates on sequences or processors fixed at compile time, in place of
+// SequenceList for claimers and waiting. min_sequence() is unrolled and inlined over the
+// tuple, no pointer chasing, no virtual call on final processors, no heap. A diamond:
+//   BatchEventProcessor<Buffer, Journal> journal(buffer, Journal());
+//   BatchEventProcessor<Buffer, Replicate> replicate(buffer, Replicate());
+//   auto both = make_sequence_tuple(journal, replicate);
+//   BatchEventProcessor<Buffer, Business, decltype(both)> business(buffer, Business(), both);
+//   auto gating = make_sequence_tuple(business);
+//   size_t seq = buffer.claim_next(1, gating);
+// =======================================================================================
+template <typename... Sequences>
+class SequenceTuple
+{
+  static_assert(sizeof...(Sequences) > 0, "Gating on nothing");
+
+public:
+  explicit SequenceTuple(Sequences&... seqs) : seqs_(seqs...) { }
+
+  size_t min_sequence() const { return aux::min_of<sizeof...(Sequences)>::get(seqs_); }
+  // Never empty, for the interface of SequenceList
+  size_t min_sequence(size_t) const { return min_sequence(); }
+  bool empty() const { return false; }
+
+private:
+  std::tuple<Sequences&...> seqs_;
+};
+
+template <typename... Sequences>
+inline SequenceTuple<Sequences...> make_sequence_tuple(Sequences&... seqs)
+{
+  return SequenceTuple<Sequences...>(seqs...);
+}
+
+} } } // namespace ku::fusion::disruptor
+
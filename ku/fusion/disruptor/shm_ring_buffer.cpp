@@ -0,0 +1,168 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <signal.h>
+#include <unistd.h>
+#include "util.hpp"
+#include "shm_ring_buffer.hpp"
+
+namespace {
+
+char const Magic[8] = "KUSHMRB";
+size_t const Alignment = ku::fusion::util::CacheAlign;
+
+inline size_t align(size_t n) { return (n + Alignment - 1) & ~(Alignment - 1); }
+
+size_t claimer_offset() { return align(sizeof(ku::fusion::disruptor::ShmHeader)); }
+size_t consumers_offset() { return claimer_offset() + align(sizeof(ku::fusion::disruptor::Claimer)); }
+size_t entries_offset(uint32_t max_consumers)
+{
+  return consumers_offset() + align(sizeof(ku::fusion::disruptor::ShmConsumer) * max_consumers);
+}
+
+bool alive(pid_t pid) { return ::kill(pid, 0) == 0 || errno != ESRCH; }
+
+} // unamed namespace
+
+namespace ku { namespace fusion { namespace disruptor {
+
+ShmRing::ShmRing(char const* name, size_t size, uint32_t max_consumers, size_t event_size)
+{
+  assert(size > 0 && max_consumers > 0);
+  size_t const capacity = util::ceiling_pow_of_two(size);
+  segment_.create(name, entries_offset(max_consumers) + capacity * event_size);
+
+  char* data = static_cast<char*>(segment_.data());
+  header_ = new (data) ShmHeader;
+  std::memcpy(header_->magic, Magic, sizeof(Magic));
+  header_->version = ShmHeader::Version;
+  header_->max_consumers = max_consumers;
+  header_->capacity = capacity;
+  header_->event_size = event_size;
+  header_->segment_size = segment_.size();
+  header_->publisher.store(::getpid(), std::memory_order_relaxed);
+  header_->generation.store(0, std::memory_order_relaxed);
+  new (data + claimer_offset()) Claimer(capacity);
+  for (uint32_t n = 0; n < max_consumers; ++n)
+    new (data + consumers_offset() + sizeof(ShmConsumer) * n) ShmConsumer(capacity - 1);
+  map(max_consumers);
+  header_->ready.store(1, std::memory_order_release);
+}
+
+ShmRing::ShmRing(char const* name, size_t event_size)
+{
+  segment_.open(name);
+  header_ = static_cast<ShmHeader*>(segment_.data());
+  if (segment_.size() < sizeof(ShmHeader) || !header_->ready.load(std::memory_order_acquire))
+    throw std::system_error(util::errc(EAGAIN), "ShmRing::ShmRing");
+  if (std::memcmp(header_->magic, Magic, sizeof(Magic)) || header_->version != ShmHeader::Version
+      || header_->event_size != event_size || header_->segment_size != segment_.size()
+      || segment_.size() != entries_offset(header_->max_consumers) + header_->capacity * event_size)
+    throw std::system_error(util::errc(EPROTO), "ShmRing::ShmRing");
+  map(header_->max_consumers);
+}
+
+ShmRing::~ShmRing()
+{
+  while (!attached_.empty())
+    detach(*attached_.back());
+  if (segment_.owner())
+    header_->publisher.store(0, std::memory_order_release);
+}
+
+void ShmRing::map(uint32_t max_consumers)
+{
+  char* data = static_cast<char*>(segment_.data());
+  claimer_ = reinterpret_cast<Claimer*>(data + claimer_offset());
+  consumers_ = reinterpret_cast<ShmConsumer*>(data + consumers_offset());
+  entries_ = data + entries_offset(max_consumers);
+  generation_ = header_->generation.load(std::memory_order_acquire) - 1; // syncs on 1st claim
+  gating_.assign(max_consumers, false);
+}
+
+uint32_t ShmRing::consumer_count() const
+{
+  uint32_t count = 0;
+  for (uint32_t n = 0; n < max_consumers(); ++n)
+    count += consumers_[n].pid.load(std::memory_order_acquire) != 0;
+  return count;
+}
+
+bool ShmRing::publisher_alive() const
+{
+  pid_t pid = header_->publisher.load(std::memory_order_acquire);
+  return pid && alive(pid);
+}
+
+Sequence& ShmRing::attach()
+{
+  attached_.reserve(attached_.size() + 1);
+  for (uint32_t n = 0; n < max_consumers(); ++n) {
+    ShmConsumer& consumer = consumers_[n];
+    int32_t free = 0;
+    if (!consumer.pid.compare_exchange_strong(free, ::getpid()))
+      continue;
+    // As RingBuffer::add_gating(), set again once the publisher can see it
+    consumer.sequence.set(cursor());
+    header_->generation.fetch_add(1, std::memory_order_acq_rel);
+    consumer.sequence.set(cursor());
+    attached_.push_back(&consumer.sequence);
+    return consumer.sequence;
+  }
+  throw std::system_error(util::errc(EBUSY), "ShmRing::attach");
+}
+
+void ShmRing::detach(Sequence& seq)
+{
+  // Sequence is the 1st member of ShmConsumer
+  ShmConsumer& consumer = reinterpret_cast<ShmConsumer&>(seq);
+  assert(&consumer >= consumers_ && &consumer < consumers_ + max_consumers());
+  consumer.pid.store(0, std::memory_order_release);
+  header_->generation.fetch_add(1, std::memory_order_acq_rel);
+  for (auto it = attached_.begin(); it != attached_.end(); ++it) {
+    if (*it == &seq) {
+      attached_.erase(it);
+      break;
+    }
+  }
+}
+
+size_t ShmRing::reap()
+{
+  size_t count = 0;
+  for (uint32_t n = 0; n < max_consumers(); ++n) {
+    int32_t pid = consumers_[n].pid.load(std::memory_order_acquire);
+    if (pid && !alive(pid) && consumers_[n].pid.compare_exchange_strong(pid, 0))
+      ++count;
+  }
+  if (count)
+    header_->generation.fetch_add(1, std::memory_order_acq_rel);
+  sync_gatings();
+  return count;
+}
+
+void ShmRing::sync()
+{
+  // Reading generation 1st, changes after it are picked up next time
+  generation_ = header_->generation.load(std::memory_order_acquire);
+  for (uint32_t n = 0; n < max_consumers(); ++n) {
+    bool const attached = consumers_[n].pid.load(std::memory_order_acquire) != 0;
+    if (attached == gating_[n])
+      continue;
+    if (attached)
+      gating_seqs_.add(&consumers_[n].sequence);
+    else
+      gating_seqs_.remove(&consumers_[n].sequence);
+    gating_[n] = attached;
+  }
+}
+
+} } } // namespace ku::fusion::disruptor
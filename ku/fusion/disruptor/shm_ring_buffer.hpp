@@ -0,0 +1,173 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <sys/types.h>
+#include "../util.hpp"
+#include "sequence.hpp"
+#include "claimer.hpp"
+#include "waiting.hpp"
+#include "shm_segment.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+// =======================================================================================
+// ShmRingBuffer is a RingBuffer in a named shared memory segment (shm://name), with one
+// publisher process and consumer processes attaching to it. The segment is
+//   ShmHeader | Claimer | ShmConsumer[max_consumers] | Event[capacity]
+// the Claimer and the sequences being the same as RingBuffer's, so is the gating logic.
+//
+// A consumer attaches to a free slot, starting at the cursor, and detaches when done.
+// The publisher gates on the attached slots, it picks up changes by a generation count
+// in the header. Slots of consumers that die attached are freed by reap(), which the
+// publisher calls itself while waiting for them. Liveness is by pid, kill(pid, 0), so a
+// dead consumer is freed once its parent has waited for it.
+//
+// Waiting can only be non-blocking, BusySpinWaiting or YieldWaiting, blocking ones park
+// on process local state.
+// =======================================================================================
+struct ShmHeader
+{
+  static uint32_t const Version = 4; // bumped as the layout of Claimer changes
+
+  char magic[8]; // "KUSHMRB"
+  uint32_t version;
+  uint32_t max_consumers;
+  uint64_t capacity;
+  uint64_t event_size;
+  uint64_t segment_size;
+  std::atomic<int32_t> publisher; // pid, 0 once it leaves
+  std::atomic<uint32_t> generation; // bumped by consumers attaching or leaving
+  std::atomic<uint32_t> ready;
+};
+
+struct ShmConsumer
+{
+  explicit ShmConsumer(size_t seq) : sequence(seq), pid(0) { }
+
+  Sequence sequence;
+  std::atomic<int32_t> pid; // 0 if free
+};
+
+class ShmRing : private util::noncopyable
+{
+public:
+  size_t capacity() const { return header_->capacity; }
+  size_t cursor() const { return claimer_->cursor().get(); }
+  uint32_t max_consumers() const { return header_->max_consumers; }
+  uint32_t consumer_count() const;
+  bool publisher_alive() const;
+
+  // For consumers, the sequence to move on processing, throws if all slots are taken
+  Sequence& attach();
+  void detach(Sequence& seq);
+  // Frees slots of dead consumers, returns how many
+  size_t reap();
+
+protected:
+  // Publisher, creating the segment
+  ShmRing(char const* name, size_t size, uint32_t max_consumers, size_t event_size);
+  // Consumer, opening the segment of a publisher
+  ShmRing(char const* name, size_t event_size);
+  ~ShmRing();
+
+  void* entries() const { return entries_; }
+  void sync_gatings()
+  {
+    if (header_->generation.load(std::memory_order_acquire) != generation_)
+      sync();
+  }
+
+private:
+  void map(uint32_t max_consumers);
+  void sync();
+
+protected:
+  Claimer* claimer_;
+  SequenceList gating_seqs_, no_deps_;
+
+private:
+  ShmSegment segment_;
+  ShmHeader* header_;
+  ShmConsumer* consumers_;
+  void* entries_;
+  uint32_t generation_;
+  std::vector<bool> gating_; // slots in gating_seqs_
+  std::vector<Sequence*> attached_; // by this process
+};
+
+template <typename Event, typename Waiting = YieldWaiting>
+class ShmRingBuffer : public ShmRing
+{
+  static_assert(std::is_trivially_copyable<Event>::value, "Event is copied between processes");
+  static_assert(std::is_empty<Waiting>::value, "Blocking Waiting doesn't work across processes");
+
+  // Claimer backs off through it, reaping dead consumers now and then
+  struct Reaping
+  {
+    void idle(size_t count)
+    {
+      buffer.waiting_.idle(count);
+      if (count % ReapInterval == 0)
+        buffer.reap();
+    }
+    ShmRingBuffer& buffer;
+  };
+
+public:
+  using EventType = Event;
+  using WaitingType = Waiting;
+  using ClaimingType = Claimer;
+
+  ShmRingBuffer(char const* name, size_t size, uint32_t max_consumers = 8)
+    : ShmRing(name, size, max_consumers, sizeof(Event)), mask_(capacity() - 1)
+  {}
+  explicit ShmRingBuffer(char const* name)
+    : ShmRing(name, sizeof(Event)), mask_(capacity() - 1)
+  {}
+
+  Event& get(size_t seq) { return static_cast<Event*>(entries())[seq & mask_]; }
+  Event const& get(size_t seq) const { return static_cast<Event const*>(entries())[seq & mask_]; }
+  Event& operator[] (size_t seq) { return get(seq); }
+  Event const& operator[] (size_t seq) const { return get(seq); }
+
+  // Publisher, as RingBuffer
+  size_t claim_next() { return claim_next(1); }
+  size_t claim_next(size_t incr)
+  {
+    sync_gatings();
+    Reaping reaping = { *this };
+    return claimer_->claim_next(incr, gating_seqs_, reaping);
+  }
+  bool has_available(size_t capacity) { sync_gatings(); return claimer_->has_available(capacity, gating_seqs_); }
+  bool wait_for_capacity(size_t capacity, WaitStop const& stop = WaitStop())
+  {
+    sync_gatings();
+    Reaping reaping = { *this };
+    return claimer_->wait_for_capacity(capacity, gating_seqs_, reaping, stop);
+  }
+  void publish(size_t seq) { claimer_->publish(seq); }
+  void publish(size_t lo, size_t hi) { claimer_->publish(lo, hi); }
+
+  // Consumer, as RingBuffer
+  size_t wait_for(size_t seq, SequenceList const& deps, WaitStop const& stop = WaitStop())
+  { return waiting_.wait_for(seq, claimer_->cursor(), deps, stop); }
+  size_t wait_for(size_t seq) { return wait_for(seq, no_deps_); }
+
+  Waiting& waiting() { return waiting_; }
+
+private:
+  static size_t const ReapInterval = 1024;
+
+  size_t const mask_;
+  Waiting waiting_;
+};
+
+} } } // namespace ku::fusion::disruptor
@@ -0,0 +1,92 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../endpoint.hpp"
+#include "shm_segment.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+std::string ShmSegment::shm_name(char const* name)
+{
+  Endpoint ep;
+  if (std::strstr(name, "://")) {
+    if (!ep.resolve(name) || ep.protocol() != Protocol::Shm)
+      throw std::system_error(util::errc(EINVAL), "ShmSegment::shm_name");
+    name = ep.address().c_str();
+  }
+  if (!*name || std::strchr(name + 1, '/'))
+    throw std::system_error(util::errc(EINVAL), "ShmSegment::shm_name");
+  return *name == '/' ? std::string(name) : '/' + std::string(name);
+}
+
+void ShmSegment::create(char const* name, size_t size)
+{
+  close();
+  std::string shm = shm_name(name);
+  // A segment left by a crashed publisher is replaced, who has it mapped keeps it
+  ::shm_unlink(shm.c_str());
+  int fd = ::shm_open(shm.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1)
+    throw std::system_error(util::errc(), "ShmSegment::create");
+  void* data = MAP_FAILED;
+  if (::ftruncate(fd, size) == 0)
+    data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    ::shm_unlink(shm.c_str());
+    throw std::system_error(util::errc(err), "ShmSegment::create");
+  }
+  data_ = data;
+  size_ = size;
+  name_.swap(shm);
+  owner_ = true;
+}
+
+void ShmSegment::open(char const* name)
+{
+  close();
+  std::string shm = shm_name(name);
+  int fd = ::shm_open(shm.c_str(), O_RDWR, 0);
+  if (fd == -1)
+    throw std::system_error(util::errc(), "ShmSegment::open");
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (::fstat(fd, &st) == 0) {
+    errno = EAGAIN; // being created
+    if (st.st_size > 0)
+      data = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int err = errno;
+  ::close(fd);
+  if (data == MAP_FAILED)
+    throw std::system_error(util::errc(err), "ShmSegment::open");
+  data_ = data;
+  size_ = st.st_size;
+  name_.swap(shm);
+  owner_ = false;
+}
+
+void ShmSegment::close()
+{
+  if (!data_)
+    return;
+  ::munmap(data_, size_);
+  if (owner_)
+    ::shm_unlink(name_.c_str());
+  data_ = nullptr;
+  size_ = 0;
+  name_.clear();
+  owner_ = false;
+}
+
+} } } // namespace ku::fusion::disruptor
@@ -0,0 +1,40 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <string>
+#include "../util.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+// Named POSIX shared memory, mapped read-write. Names are "shm://name" or "name".
+class ShmSegment : private util::noncopyable
+{
+public:
+  ShmSegment() : data_(nullptr), size_(0), owner_(false) { }
+  ~ShmSegment() { close(); }
+
+  // Replaces any existing segment of the name, which is unlinked on close
+  void create(char const* name, size_t size);
+  void open(char const* name);
+  void close();
+
+  void* data() const { return data_; }
+  size_t size() const { return size_; }
+  std::string const& name() const { return name_; }
+  bool owner() const { return owner_; }
+
+  static std::string shm_name(char const* name);
+
+private:
+  void* data_;
+  size_t size_;
+  std::string name_;
+  bool owner_;
+};
+
+} } } // namespace ku::fusion::disruptor
@@ -0,0 +1,69 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cstdint>
+#include <system_error>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "util.hpp"
+#include "storage.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+namespace {
+
+size_t round_up(size_t size, size_t align) { return (size + align - 1) / align * align; }
+
+} // unamed namespace
+
+/// HeapMemory ///
+void* HeapMemory::allocate(size_t size)
+{
+  return cache_aligned_new(size);
+}
+
+void HeapMemory::deallocate(void* p, size_t size)
+{
+  cache_aligned_delete(p);
+}
+
+/// HugePageMemory ///
+void* HugePageMemory::allocate(size_t size)
+{
+  size = round_up(size, PageSize);
+#ifdef MAP_HUGETLB
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+  if (p != MAP_FAILED)
+    return p;
+#endif
+  // No huge page reserved, maps a page more to align to one, so transparent huge pages
+  // back it all
+  char* raw = static_cast<char*>(::mmap(nullptr, size + PageSize, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (raw == MAP_FAILED)
+    throw std::system_error(util::errc(), "HugePageMemory::allocate");
+  char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), PageSize));
+  if (aligned != raw)
+    ::munmap(raw, aligned - raw);
+  ::munmap(aligned + size, raw + PageSize - aligned);
+#ifdef MADV_HUGEPAGE
+  ::madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+  // Faults in after madvise, MAP_POPULATE would have faulted in small pages
+  long const small = ::sysconf(_SC_PAGESIZE);
+  for (size_t off = 0; off < size; off += small)
+    aligned[off] = 0;
+  return aligned;
+}
+
+void HugePageMemory::deallocate(void* p, size_t size)
+{
+  ::munmap(p, round_up(size, PageSize));
+}
+
+} } } // namespace ku::fusion::disruptor
+
@@ -0,0 +1,216 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "../util.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+// Storage policies lay out the entries of RingBuffer, each provides
+//   template <typename Event> Entries, with Entries(size), size(), operator[] (idx) and
+//   the reference, const_reference types operator[] returns
+// Entries are constructed and touched once at construction, so publishing never page
+// faults.
+
+// Memory of padded and column storage, cache line aligned
+struct HeapMemory
+{
+  static void* allocate(size_t size);
+  static void deallocate(void* p, size_t size);
+};
+
+// 2MB huge pages, transparent huge pages if none is reserved, prefaulted
+struct HugePageMemory
+{
+  static size_t const PageSize = 2 * 1024 * 1024;
+
+  static void* allocate(size_t size);
+  static void deallocate(void* p, size_t size);
+};
+
+namespace aux {
+
+template <typename Event, size_t Align>
+struct Slot
+{
+  alignas(Align) Event event;
+};
+
+template <typename Event>
+struct Slot<Event, 0>
+{
+  Event event;
+};
+
+// Events each in a slot of Align bytes, or packed if Align is 0
+template <typename Event, size_t Align, typename Memory>
+class SlotArray : private util::noncopyable
+{
+  static_assert((Align & (Align - 1)) == 0 && Align <= 128, "Align is 0 or a power of two up to 128");
+  using SlotType = Slot<Event, Align>;
+
+public:
+  using reference = Event&;
+  using const_reference = Event const&;
+
+  explicit SlotArray(size_t size);
+  ~SlotArray();
+
+  size_t size() const { return size_; }
+  Event& operator[] (size_t idx) { return slots_[idx].event; }
+  Event const& operator[] (size_t idx) const { return slots_[idx].event; }
+
+private:
+  size_t const size_;
+  SlotType* const slots_;
+};
+
+template <typename Event, size_t Align, typename Memory>
+SlotArray<Event, Align, Memory>::SlotArray(size_t size)
+  : size_(size), slots_(static_cast<SlotType*>(Memory::allocate(size * sizeof(SlotType))))
+{
+  size_t n = 0;
+  try {
+    for (; n < size_; ++n)
+      new (&slots_[n]) SlotType();
+  } catch (...) {
+    while (n > 0)
+      slots_[--n].~SlotType();
+    Memory::deallocate(slots_, size_ * sizeof(SlotType));
+    throw;
+  }
+}
+
+template <typename Event, size_t Align, typename Memory>
+SlotArray<Event, Align, Memory>::~SlotArray()
+{
+  for (size_t n = 0; n < size_; ++n)
+    slots_[n].~SlotType();
+  Memory::deallocate(slots_, size_ * sizeof(SlotType));
+}
+
+template <typename T>
+class Column : private util::noncopyable
+{
+public:
+  explicit Column(size_t size)
+    : data_(static_cast<T*>(HeapMemory::allocate(size * sizeof(T)))), size_(size)
+  { std::memset(data_, 0, size * sizeof(T)); }
+  Column(Column&& other) : data_(other.data_), size_(other.size_) { other.data_ = nullptr; }
+  ~Column() { if (data_) HeapMemory::deallocate(data_, size_ * sizeof(T)); }
+
+  T* data() const { return data_; }
+
+private:
+  T* data_;
+  size_t size_;
+};
+
+template <size_t... Indices>
+struct indices { };
+
+template <size_t N, size_t... Indices>
+struct make_indices : make_indices<N - 1, N - 1, Indices...> { };
+
+template <size_t... Indices>
+struct make_indices<0, Indices...>
+{
+  using type = indices<Indices...>;
+};
+
+template <bool... Values>
+struct bools { };
+
+template <bool... Values>
+struct all_of : std::is_same<bools<Values..., true>, bools<true, Values...>> { };
+
+// Each field of the tuple Event in its own array, read as a tuple of references
+template <typename Event>
+class ColumnArray;
+
+template <typename... Fields>
+class ColumnArray<std::tuple<Fields...>>
+{
+  static_assert(sizeof...(Fields) > 0, "Columns of an empty tuple");
+  static_assert(all_of<std::is_trivially_copyable<Fields>::value...>::value,
+                "Columns of trivially copyable fields");
+  using Indices = typename make_indices<sizeof...(Fields)>::type;
+
+public:
+  using reference = std::tuple<Fields&...>;
+  using const_reference = std::tuple<Fields const&...>;
+
+  explicit ColumnArray(size_t size) : size_(size), columns_(Column<Fields>(size)...) { }
+
+  size_t size() const { return size_; }
+  reference operator[] (size_t idx) { return at(idx, Indices()); }
+  const_reference operator[] (size_t idx) const { return at(idx, Indices()); }
+
+private:
+  template <size_t... I>
+  reference at(size_t idx, indices<I...>) { return reference(std::get<I>(columns_).data()[idx]...); }
+  template <size_t... I>
+  const_reference at(size_t idx, indices<I...>) const
+  { return const_reference(std::get<I>(columns_).data()[idx]...); }
+
+  size_t const size_;
+  std::tuple<Column<Fields>...> columns_;
+};
+
+} // namespace ku::fusion::disruptor::aux
+
+// =====================================================================================
+// std::vector, events packed back to back. Events smaller than a cache line share one
+// with their neighbours, a slow consumer reading a slot contends with the publisher
+// writing the next.
+// =====================================================================================
+struct VectorStorage
+{
+  template <typename Event>
+  using Entries = std::vector<Event>;
+};
+
+// =====================================================================================
+// Each event in a slot of Align bytes, 64 isolates them on x86, 128 also against the
+// adjacent line prefetcher
+// =====================================================================================
+template <size_t Align = 64>
+struct PaddedStorage
+{
+  template <typename Event>
+  using Entries = aux::SlotArray<Event, Align, HeapMemory>;
+};
+
+// =====================================================================================
+// Events on 2MB pages, a ring of a few MB is then mapped by a handful of TLB entries.
+// Align pads slots as PaddedStorage does, 0 packs them.
+// =====================================================================================
+template <size_t Align = 0>
+struct HugePageStorage
+{
+  template <typename Event>
+  using Entries = aux::SlotArray<Event, Align, HugePageMemory>;
+};
+
+// =====================================================================================
+// Struct of arrays for events of std::tuple<Fields...> of trivially copyable fields,
+// consumers touching a few fields only load those. RingBuffer::get() returns
+// std::tuple<Fields&...>, handlers take it by value.
+// =====================================================================================
+struct ColumnStorage
+{
+  template <typename Event>
+  using Entries = aux::ColumnArray<Event>;
+};
+
+} } } // namespace ku::fusion::disruptor
+
@@ -0,0 +1,182 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "sequence.hpp"
+#include "event_processor.hpp"
+#include "work_processor.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+// =======================================================================================
+// Topology wires handlers into processors of a RingBuffer, each stage waiting for the
+// stages it is declared after, e.g. journaller and replicator in parallel, then business
+// logic after both, a diamond:
+//   Topology<Buffer> topology(buffer);
+//   topology.handle_with(journaller, replicator).then(logic);
+// or the same with a group kept aside:
+//   auto input = topology.handle_with(journaller, replicator);
+//   topology.after(input).handle_with(logic);
+// Pools of workers, each event handled by one of them (see WorkProcessor), are stages
+// just as well:
+//   topology.handle_with(journaller).then_pool(4, validator).then(matcher);
+// Processors nothing waits for gate the publisher, start() sets them to the buffer and
+// runs each processor on its own thread.
+// =======================================================================================
+template <typename RingBuffer>
+class Topology
+{
+public:
+  class Group
+  {
+  public:
+    // Processors of handlers, each waiting for all of this group
+    template <typename... Handlers>
+    Group then(Handlers... handlers) { return topology_.create(sequences_, std::move(handlers)...); }
+    // A pool of size workers of handler copies, waiting for all of this group
+    template <typename Handler>
+    Group then_pool(size_t size, Handler const& handler) { return topology_.create_pool(sequences_, size, handler); }
+    // Same as then() and then_pool(), read better after Topology::after()
+    template <typename... Handlers>
+    Group handle_with(Handlers... handlers) { return then(std::move(handlers)...); }
+    template <typename Handler>
+    Group handle_with_pool(size_t size, Handler const& handler) { return then_pool(size, handler); }
+
+    std::vector<Sequence*> const& sequences() const { return sequences_; }
+
+  private:
+    friend class Topology;
+    Group(Topology& topology) : topology_(topology) { }
+
+  private:
+    Topology& topology_;
+    std::vector<Sequence*> sequences_;
+  };
+
+public:
+  Topology(RingBuffer& buffer) : buffer_(buffer) { }
+  ~Topology() { halt(); join(); }
+
+  Topology(Topology const&) = delete;
+  Topology& operator=(Topology const&) = delete;
+
+  // Processors of handlers, waiting for the publisher only
+  template <typename... Handlers>
+  Group handle_with(Handlers... handlers) { return create(std::vector<Sequence*>(), std::move(handlers)...); }
+  // A pool of size workers of handler copies, waiting for the publisher only
+  template <typename Handler>
+  Group handle_with_pool(size_t size, Handler const& handler)
+  { return create_pool(std::vector<Sequence*>(), size, handler); }
+
+  // Group of all the groups, for processors waiting for them all
+  template <typename... Groups>
+  Group after(Group const& group, Groups const&... groups)
+  {
+    Group merged = after(groups...);
+    merged.sequences_.insert(merged.sequences_.begin(), group.sequences_.begin(), group.sequences_.end());
+    return merged;
+  }
+  Group after() { return Group(*this); }
+
+  // Processors nothing waits for, the gating sequences of the buffer
+  std::vector<Sequence*> leaves() const;
+  std::vector<std::unique_ptr<EventProcessor>> const& processors() const { return processors_; }
+
+  // Sets the gatings of the buffer, and runs each processor on its own thread
+  void start();
+  // Halting takes effect at batch boundary, processors waiting for events are woken up
+  void halt();
+  void join();
+
+private:
+  template <typename Handler, typename... Handlers>
+  Group create(std::vector<Sequence*> const& deps, Handler handler, Handlers... handlers)
+  {
+    using Processor = BatchEventProcessor<RingBuffer, Handler>;
+    std::unique_ptr<Processor> owner(new Processor(buffer_, std::move(handler)));
+    Processor* processor = owner.get();
+    processors_.push_back(std::move(owner));
+    if (!deps.empty())
+      processor->set_dependencies(deps);
+    gated_.insert(gated_.end(), deps.begin(), deps.end());
+    Group group = create(deps, std::move(handlers)...);
+    group.sequences_.insert(group.sequences_.begin(), &processor->sequence());
+    return group;
+  }
+
+  Group create(std::vector<Sequence*> const&) { return Group(*this); }
+
+  template <typename Handler>
+  Group create_pool(std::vector<Sequence*> const& deps, size_t size, Handler const& handler)
+  {
+    assert(size > 0);
+    using Processor = WorkProcessor<RingBuffer, Handler>;
+    work_seqs_.emplace_back(new Sequence(buffer_.cursor()));
+    Group group(*this);
+    for (size_t n = 0; n < size; ++n) {
+      std::unique_ptr<Processor> owner(new Processor(buffer_, *work_seqs_.back(), handler));
+      if (!deps.empty())
+        owner->set_dependencies(deps);
+      group.sequences_.push_back(&owner->sequence());
+      processors_.push_back(std::move(owner));
+    }
+    gated_.insert(gated_.end(), deps.begin(), deps.end());
+    return group;
+  }
+
+private:
+  RingBuffer& buffer_;
+  std::vector<std::unique_ptr<Sequence>> work_seqs_; // shared by workers of a pool
+  std::vector<std::unique_ptr<EventProcessor>> processors_;
+  std::vector<Sequence*> gated_; // sequences being waited for by others
+  std::vector<std::thread> threads_;
+};
+
+
+template <typename RingBuffer>
+std::vector<Sequence*> Topology<RingBuffer>::leaves() const
+{
+  std::vector<Sequence*> seqs;
+  for (auto const& processor : processors_) {
+    Sequence* seq = &processor->sequence();
+    if (std::find(gated_.begin(), gated_.end(), seq) == gated_.end())
+      seqs.push_back(seq);
+  }
+  return seqs;
+}
+
+template <typename RingBuffer>
+void Topology<RingBuffer>::start()
+{
+  assert(threads_.empty() && !processors_.empty());
+  buffer_.set_gatings(leaves());
+  for (auto const& processor : processors_) {
+    EventProcessor* p = processor.get();
+    threads_.emplace_back([p]() { p->run(); });
+  }
+}
+
+template <typename RingBuffer>
+void Topology<RingBuffer>::halt()
+{
+  for (auto const& processor : processors_)
+    processor->halt();
+}
+
+template <typename RingBuffer>
+void Topology<RingBuffer>::join()
+{
+  for (auto& thread : threads_)
+    thread.join();
+  threads_.clear();
+}
+
+} } } // namespace ku::fusion::disruptor
@@ -1,24 +0,0 @@
-/***************************************************************
- * Copyright 2011, Zhang, Jun. All rights reserved.            *
- * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
- *                                                             *
- * This source code is provided with absolutely no warranty.   *
- ***************************************************************/ 
-#include "util.hpp"
-
-namespace ku { namespace fusion { namespace disruptor {
-
-size_t next_pow_of_two(size_t val)
-{
-  --val;
-  val |= val >> 1;
-  val |= val >> 2;
-  val |= val >> 4;
-  val |= val >> 8;
-  val |= val >> 16;
-  val |= val >> 32;
-  return ++val;
-}
-
-} } } // namespace ku::fusion::disruptor
-
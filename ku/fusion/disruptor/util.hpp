@@ -5,11 +5,13 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
-#include <cstddef>
+#include "../util.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
-size_t next_pow_of_two(size_t val);
+using util::cache_aligned_new;
+using util::cache_aligned_delete;
+using util::cpu_relax;
 
 } } } // namespace ku::fusion::disruptor
 
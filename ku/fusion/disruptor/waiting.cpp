@@ -4,14 +4,77 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include "waiting.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
-void YieldWaiting::wait_for(size_t seq, Sequence const& cursor, SequenceList const& seq_list)
+/// FutexWaiting ///
+size_t FutexWaiting::block(size_t seq, Sequence const& cursor, WaitStop const& stop)
 {
-  // TODO
+  timespec timeout, *timeout_ptr = nullptr;
+  if (stop.timed()) {
+    auto const left = stop.deadline() - WaitStop::Clock::now();
+    if (left <= WaitStop::Clock::duration::zero())
+      return cursor.get();
+    auto const nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+    timeout.tv_sec = nanos / 1000000000;
+    timeout.tv_nsec = nanos % 1000000000;
+    timeout_ptr = &timeout;
+  }
+  // Reading epoch before registering, a wake in between changes it and futex returns
+  uint32_t const epoch = epoch_.load(std::memory_order_acquire);
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  size_t available = cursor.get();
+  if (available < seq && !stop.alerted()) {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch,
+              timeout_ptr, nullptr, 0);
+    available = cursor.get();
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return available;
 }
 
-} } } // namespace ku::fusion::disruptor
+void FutexWaiting::wake()
+{
+  epoch_.fetch_add(1, std::memory_order_release);
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+/// ConditionWaiting ///
+size_t ConditionWaiting::block(size_t seq, Sequence const& cursor, WaitStop const& stop)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  size_t available;
+  while ((available = cursor.get()) < seq && !stop.alerted()) {
+    if (!stop.timed()) {
+      cond_.wait(lock);
+    } else if (cond_.wait_until(lock, stop.deadline()) == std::cv_status::timeout) {
+      available = cursor.get();
+      break;
+    }
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return available;
+}
 
+void ConditionWaiting::notify_all()
+{
+  // Pairs with the fence in block(), either the waiter sees the new cursor or we see it
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load(std::memory_order_relaxed)) {
+    // Waiter registered but not yet waiting holds the lock, it can't miss the notify
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    cond_.notify_all();
+  }
+}
+
+} } } // namespace ku::fusion::disruptor
@@ -6,22 +6,246 @@
  ***************************************************************/ 
 #pragma once
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "util.hpp"
 #include "sequence.hpp"
 
 namespace ku { namespace fusion { namespace disruptor {
 
+// =======================================================================================
+// WaitStop ends waits early, once alerted, for a consumer to halt, or at a deadline, for
+// it to do periodic work in quiet periods. Waits ended early return a sequence lower
+// than the one waited for. The default one never stops, and costs nothing.
+// =======================================================================================
+class WaitStop
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  WaitStop() : alerted_(nullptr), deadline_(Clock::time_point::max()) { }
+  explicit WaitStop(std::atomic<bool> const* alerted,
+                    Clock::time_point deadline = Clock::time_point::max())
+    : alerted_(alerted), deadline_(deadline) { }
+
+  bool alerted() const { return alerted_ && alerted_->load(std::memory_order_acquire); }
+  bool timed() const { return deadline_ != Clock::time_point::max(); }
+  Clock::time_point deadline() const { return deadline_; }
+  bool expired() const { return timed() && Clock::now() >= deadline_; }
+  bool stopped() const { return alerted() || expired(); }
+  // For the count'th round of a spin, reads the clock once every 64 rounds only
+  bool stopped(size_t count) const { return alerted() || (count % 64 == 0 && expired()); }
+
+  // The same, with the sooner of the deadlines
+  WaitStop sooner(Clock::time_point deadline) const
+  { return WaitStop(alerted_, deadline < deadline_ ? deadline : deadline_); }
+
+private:
+  std::atomic<bool> const* alerted_;
+  Clock::time_point deadline_;
+};
+
+// =======================================================================================
+// Waiting strategies, the Waiting parameter of RingBuffer. Each one provides:
+//   size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps,
+//                   WaitStop const& stop = WaitStop())
+//     for consumers, waits until seq is published and processed by all of deps,
+//     returns the highest sequence available, which may be beyond seq. Deps is
+//     SequenceList, or SequenceTuple, see sequence_tuple.hpp. Stopped early by stop.
+//   void notify_all()
+//     called by the publisher after moving the cursor, and to wake waiters alerted
+//   void idle(size_t count)
+//     backing off for the count'th time, for claimer waiting for consumers
+// Only the cursor is signalled, consumers waiting for their dependents and claimer
+// waiting for consumers back off with idle(). From the lowest latency to the lowest cpu:
+//   BusySpinWaiting: spins with pause, needs a core for each consumer
+//   YieldWaiting: spins with yield, gives the core away when others need it
+//   PhasedWaiting: spins, then yields, then blocks on futex
+//   FutexWaiting: blocks on futex after a short spin, publishing costs a syscall only
+//     if anyone is blocked
+//   ConditionWaiting: blocks on condition variable, portable version of FutexWaiting
+//   TimeoutBlockingWaiting: ConditionWaiting which gives up after timeout, returning a
+//     sequence lower than the one waited for
+// =======================================================================================
+template <typename Waiting, typename Deps>
+size_t wait_for_deps(Waiting& waiting, size_t seq, size_t available, Deps const& deps,
+                     WaitStop const& stop)
+{
+  if (deps.empty())
+    return available;
+  size_t min_seq;
+  for (size_t count = 0; (min_seq = deps.min_sequence(available)) < seq; ) {
+    if (stop.stopped(++count))
+      break;
+    waiting.idle(count);
+  }
+  return min_seq;
+}
+
+class BusySpinWaiting
+{
+public:
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t available;
+    for (size_t count = 0; (available = cursor.get()) < seq; ) {
+      if (stop.stopped(++count))
+        return available;
+      idle(count);
+    }
+    return wait_for_deps(*this, seq, available, deps, stop);
+  }
+
+  void notify_all() { }
+  void idle(size_t) { cpu_relax(); }
+};
+
+class YieldWaiting
+{
+public:
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t available;
+    for (size_t count = 0; (available = cursor.get()) < seq; ) {
+      if (stop.stopped(++count))
+        return available;
+      idle(count);
+    }
+    return wait_for_deps(*this, seq, available, deps, stop);
+  }
+
+  void notify_all() { }
+  void idle(size_t count) { count < SpinTries ? cpu_relax() : std::this_thread::yield(); }
+
+private:
+  static size_t const SpinTries = 100;
+};
+
+class FutexWaiting
+{
+public:
+  FutexWaiting() : epoch_(0), waiters_(0) { }
+
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t available;
+    for (size_t count = 0; (available = cursor.get()) < seq; ++count) {
+      if (count < SpinTries) {
+        if (stop.stopped(count + 1))
+          return available;
+        cpu_relax();
+      } else {
+        if (stop.stopped())
+          return available;
+        available = block(seq, cursor, stop);
+      }
+    }
+    return wait_for_deps(*this, seq, available, deps, stop);
+  }
+
+  void notify_all()
+  {
+    // Pairs with the fence in block(), either the waiter sees the new cursor or we see it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed))
+      wake();
+  }
+
+  void idle(size_t count) { count < SpinTries ? cpu_relax() : std::this_thread::yield(); }
+
+protected:
+  // Returns early once stop is alerted or at its deadline
+  size_t block(size_t seq, Sequence const& cursor, WaitStop const& stop);
+  void wake();
+
+protected:
+  static size_t const SpinTries = 100;
+
+private:
+  std::atomic<uint32_t> epoch_; // futex word, bumped on every wake
+  std::atomic<uint32_t> waiters_;
+};
+
+class PhasedWaiting : public FutexWaiting
+{
+public:
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t available;
+    for (size_t count = 0; (available = cursor.get()) < seq; ++count) {
+      if (count < SpinTries + YieldTries) {
+        if (stop.stopped(count + 1))
+          return available;
+        count < SpinTries ? cpu_relax() : std::this_thread::yield();
+      } else {
+        if (stop.stopped())
+          return available;
+        available = block(seq, cursor, stop);
+      }
+    }
+    return wait_for_deps(*this, seq, available, deps, stop);
+  }
+
+private:
+  static size_t const SpinTries = 10000, YieldTries = 100;
+};
+
 class ConditionWaiting
 {
 public:
+  ConditionWaiting() : waiters_(0) { }
+
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t available = cursor.get();
+    if (available < seq && (available = block(seq, cursor, stop)) < seq)
+      return available;
+    return wait_for_deps(*this, seq, available, deps, stop);
+  }
+
   void notify_all();
+  void idle(size_t) { std::this_thread::yield(); }
+
+protected:
+  // Returns a sequence lower than seq once stop is alerted or at its deadline
+  size_t block(size_t seq, Sequence const& cursor, WaitStop const& stop);
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<uint32_t> waiters_;
 };
 
-class YieldWaiting
+class TimeoutBlockingWaiting : public ConditionWaiting
 {
 public:
-  void wait_for(size_t seq, Sequence const& cursor, SequenceList const& seq_list);
-  void notify_all() {}
+  explicit TimeoutBlockingWaiting(std::chrono::nanoseconds timeout = std::chrono::milliseconds(1))
+    : timeout_(timeout) { }
+
+  // Returns a sequence lower than seq on timeout
+  template <typename Deps>
+  size_t wait_for(size_t seq, Sequence const& cursor, Deps const& deps, WaitStop const& stop = WaitStop())
+  {
+    size_t const available = cursor.get();
+    if (available >= seq && deps.empty())
+      return available;
+    return ConditionWaiting::wait_for(seq, cursor, deps, stop.sooner(WaitStop::Clock::now() + timeout_));
+  }
+
+  std::chrono::nanoseconds timeout() const { return timeout_; }
+  void set_timeout(std::chrono::nanoseconds timeout) { timeout_ = timeout; }
+
+private:
+  std::chrono::nanoseconds timeout_;
 };
 
 } } } // namespace ku::fusion::disruptor
-
@@ -0,0 +1,159 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "sequence.hpp"
+#include "event_processor.hpp"
+
+namespace ku { namespace fusion { namespace disruptor {
+
+// =======================================================================================
+// WorkProcessors of a pool share a work sequence, each event is handled by exactly one
+// of them, called as
+//   handler(Event& event, size_t seq)
+// A worker claims the next sequence with cas on the work sequence, after setting its own
+// sequence right before it, so the pool gates the publisher by its slowest worker.
+// =======================================================================================
+template <typename RingBuffer, typename Handler>
+class WorkProcessor final : public EventProcessor
+{
+public:
+  WorkProcessor(RingBuffer& buffer, Sequence& work_seq, Handler handler)
+    : buffer_(buffer), work_seq_(work_seq), handler_(std::move(handler))
+    , sequence_(buffer.cursor()), halted_(false)
+  {}
+
+  void set_dependencies(std::initializer_list<Sequence*> const& seqs) { deps_.initialize(seqs); }
+  void set_dependencies(std::vector<Sequence*> const& seqs) { deps_.initialize(seqs); }
+
+  virtual Sequence& sequence() { return sequence_; }
+  virtual void run();
+  virtual void halt()
+  {
+    halted_.store(true, std::memory_order_release);
+    buffer_.waiting().notify_all();
+  }
+  bool halted() const { return halted_.load(std::memory_order_acquire); }
+
+  Handler& handler() { return handler_; }
+
+private:
+  RingBuffer& buffer_;
+  Sequence& work_seq_;
+  Handler handler_;
+  Sequence sequence_;
+  SequenceList deps_;
+  std::atomic<bool> halted_;
+};
+
+// N WorkProcessors of copies of handler, on threads of their own once started
+template <typename RingBuffer, typename Handler>
+class WorkerPool
+{
+public:
+  using Worker = WorkProcessor<RingBuffer, Handler>;
+
+  WorkerPool(RingBuffer& buffer, size_t size, Handler const& handler);
+  ~WorkerPool() { halt(); join(); }
+
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+
+  void set_dependencies(std::vector<Sequence*> const& seqs);
+  // Sequences of the workers, to gate the publisher, or to be followed
+  std::vector<Sequence*> sequences() const;
+  std::vector<std::unique_ptr<Worker>> const& workers() const { return workers_; }
+
+  void start();
+  // Halting takes effect after the event at hand, and wakes workers waiting
+  void halt();
+  void join();
+
+private:
+  Sequence work_seq_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+};
+
+
+template <typename RingBuffer, typename Handler>
+void WorkProcessor<RingBuffer, Handler>::run()
+{
+  bool processed = true;
+  size_t available = sequence_.get(), next_seq = available;
+  while (!halted()) {
+    if (processed) {
+      processed = false;
+      do {
+        next_seq = work_seq_.get() + 1;
+        sequence_.set(next_seq - 1);
+      } while (!work_seq_.cas(next_seq - 1, next_seq));
+    }
+    if (available >= next_seq) {
+      handler_(buffer_[next_seq], next_seq);
+      processed = true;
+    } else {
+      available = buffer_.wait_for(next_seq, deps_, WaitStop(&halted_));
+    }
+  }
+}
+
+template <typename RingBuffer, typename Handler>
+WorkerPool<RingBuffer, Handler>::WorkerPool(RingBuffer& buffer, size_t size, Handler const& handler)
+  : work_seq_(buffer.cursor())
+{
+  assert(size > 0);
+  for (size_t n = 0; n < size; ++n)
+    workers_.emplace_back(new Worker(buffer, work_seq_, handler));
+}
+
+template <typename RingBuffer, typename Handler>
+void WorkerPool<RingBuffer, Handler>::set_dependencies(std::vector<Sequence*> const& seqs)
+{
+  for (auto const& worker : workers_)
+    worker->set_dependencies(seqs);
+}
+
+template <typename RingBuffer, typename Handler>
+std::vector<Sequence*> WorkerPool<RingBuffer, Handler>::sequences() const
+{
+  std::vector<Sequence*> seqs;
+  for (auto const& worker : workers_)
+    seqs.push_back(&worker->sequence());
+  return seqs;
+}
+
+template <typename RingBuffer, typename Handler>
+void WorkerPool<RingBuffer, Handler>::start()
+{
+  assert(threads_.empty());
+  for (auto const& worker : workers_) {
+    Worker* w = worker.get();
+    threads_.emplace_back([w]() { w->run(); });
+  }
+}
+
+template <typename RingBuffer, typename Handler>
+void WorkerPool<RingBuffer, Handler>::halt()
+{
+  for (auto const& worker : workers_)
+    worker->halt();
+}
+
+template <typename RingBuffer, typename Handler>
+void WorkerPool<RingBuffer, Handler>::join()
+{
+  for (auto& thread : threads_)
+    thread.join();
+  threads_.clear();
+}
+
+} } } // namespace ku::fusion::disruptor
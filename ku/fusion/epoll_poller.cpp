@@ -25,6 +25,7 @@ int translate_event_types(Notice const& notice)
 
 void translate_events(epoll_event const& ev, Notice& notice)
 {
+  notice.reset_events();
   if (ev.events & (EPOLLHUP | EPOLLRDHUP))
     notice.set_event(Notice::Close);
   if (ev.events & (EPOLLIN | EPOLLPRI))
@@ -47,36 +48,22 @@ void Notices::clear()
   notices_.clear();
 }
 
-Notice* Notices::find_notice(epoll_event const& ev)
-{
-  Notice* notice = static_cast<Notice*>(ev.data.ptr);
-  assert(notice == &notices_[notice->id()]);
-  return notice;
-}
-
 bool Notices::add_notice_internal(Notice&& notice)
 {
   assert(notice.any_event_type());
-  auto res = notices_.insert(std::make_pair(notice.id(), std::move(notice)));
-  if (res.second) {
-    Notice *notice_ptr = &(res.first->second);
-    epoll_event ev;
-    ev.data.ptr = notice_ptr;
-    ev.events = translate_event_types(*notice_ptr);
-    if (::epoll_ctl(poller().raw_handle(), EPOLL_CTL_ADD, notice_ptr->raw_handle(), &ev) == 0)
-      return true;
-    notices_.erase(res.first);
-    on_error_ && on_error_(util::errc());
+  NoticeId const id = notice.id();
+  epoll_event ev;
+  ev.data.u64 = id;
+  ev.events = translate_event_types(notice);
+  if (::epoll_ctl(poller().raw_handle(), EPOLL_CTL_ADD, notice.raw_handle(), &ev) == 0) {
+    notices_.insert(std::move(notice));
+    return true;
   }
+  notices_.release(id);
+  on_error_ && on_error_(util::errc());
   return false;
 }
 
-Notice* Notices::find_notice(NoticeId id)
-{
-  auto find = notices_.find(id);
-  return notices_.end() == find ? nullptr : &find->second;
-}
-
 bool Notices::remove_notice_internal(NoticeId id)
 {
   if (Notice* notice_ptr = find_notice(id)) {
@@ -96,6 +83,7 @@ bool Notices::modify_notice_internal(NoticeId id, Notice const& notice)
 {
   if (Notice* notice_ptr = find_notice(id)) {
     epoll_event ev;
+    ev.data.u64 = id;
     ev.events = translate_event_types(notice);
     if (::epoll_ctl(poller().raw_handle(), EPOLL_CTL_MOD, notice_ptr->raw_handle(), &ev) == 0) {
       notice_ptr->set_event_handler(notice.event_handler());
@@ -120,9 +108,10 @@ void Poller::poll(std::chrono::milliseconds const& timeout)
 {
   int event_num = ::epoll_wait(raw_handle(), &*events_.begin(), events_.size(),
                                timeout.count());
-  if (event_num == -1) { // TODO EINTR
+  if (event_num == -1) {
     active_count_ = 0;
-    throw std::system_error(util::errc(), "epoll::Poller::poll");
+    if (errno != EINTR) // a signal, the loop polls again
+      throw std::system_error(util::errc(), "epoll::Poller::poll");
   } else {
     active_count_ = event_num;
     if (active_count_ >= events_.size())
@@ -143,13 +132,15 @@ bool PollLoop::loop(std::chrono::milliseconds timeout)
   Poller poller(EPOLL_CLOEXEC);
   notices_.set_poller(&poller);
 
-  while (!quit_) {
+  while (!quit_.load(std::memory_order_acquire)) {
     notices_.apply_updates();
     poller.poll(timeout);
 
     for (unsigned i = 0; i < poller.active_count(); ++i) {
       epoll_event const& ev = poller.raw_event(i);
       Notice* notice = notices_.find_notice(ev);
+      if (!notice) // stale, its notice is gone
+        continue;
       translate_events(ev, *notice);
       dispatch(*notice, notices_);
     }
@@ -7,12 +7,12 @@
 #pragma once
 #include <sys/epoll.h>
 #include <system_error>
-#include <map>
 #include <vector>
 #include <chrono>
 #include <functional>
 #include "notice.hpp"
 #include "notice_board.hpp"
+#include "notice_slab.hpp"
 #include "poll_loop.hpp"
 
 namespace ku { namespace fusion { namespace epoll {
@@ -23,9 +23,6 @@ class Notices : public NoticeBoard
               , private util::noncopyable
 {
   friend class Poller;
-  // NoticeMap is only used when add/remove/modify notice, shouldn't be the bottleneck,
-  // consider stable_vector if really necessary
-  using NoticeMap = std::map<NoticeId, Notice>;
 
 public:
   using OnError = std::function<bool(std::error_code)>;
@@ -35,7 +32,8 @@ public:
 
   void set_poller(Poller* poller) { poller_ = poller; }
 
-  Notice* find_notice(epoll_event const& ev);
+  // The notice of an event, nullptr if it was removed since epoll_wait
+  Notice* find_notice(epoll_event const& ev) { return notices_.find(ev.data.u64); }
 
   using NoticeBoard::apply_updates;
 
@@ -47,13 +45,14 @@ private:
   virtual bool add_notice_internal(Notice&& notice);
   virtual bool remove_notice_internal(NoticeId id);
   virtual bool modify_notice_internal(NoticeId id, Notice const& notice);
-  virtual Notice* find_notice(NoticeId id);
+  virtual Notice* find_notice(NoticeId id) { return notices_.find(id); }
+  virtual NoticeId next_id() { return notices_.allocate(); }
 
   void clear();
 
 private:
   Poller* poller_;
-  NoticeMap notices_;
+  NoticeSlab notices_;
   OnError on_error_;
 };
 
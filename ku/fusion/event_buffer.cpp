@@ -33,7 +33,22 @@ void EventBuffer::claim(size_t seq)
 void EventBuffer::publish(size_t seq)
 {
   published_seq_.set(seq);
-  // TODO barrier_.notify_all();
+  barrier_.notify_all();
+}
+
+RingTelemetry EventBuffer::telemetry() const
+{
+  RingTelemetry telemetry = RingTelemetry();
+  size_t const published = published_sequence();
+  telemetry.capacity = capacity();
+  for (size_t seq : barrier_.sequences()) {
+    telemetry.lags.push_back(published - seq);
+    telemetry.occupancy = std::max(telemetry.occupancy, published - seq);
+  }
+  telemetry.publisher = stats_.snapshot();
+  telemetry.publisher.max_occupancy = std::max(telemetry.publisher.max_occupancy, telemetry.occupancy);
+  telemetry.consumers = barrier_.stats().snapshot();
+  return telemetry;
 }
 
 size_t EventBuffer::max_usable_sequence() const
@@ -52,11 +67,17 @@ size_t EventBuffer::max_usable_block_sequence() const
 void EventBuffer::wait_for_seq(size_t seq)
 {
   size_t const wrap_point = seq - capacity();
-  if (wrap_point > gating_seq_.get()) {
-    size_t min_seq;
-    size_t wait_count = 0;
-    while (wrap_point > (min_seq = barrier_.min_sequence()))
-      wait_strategy_(wait_count++);
+  if (wrap_point > gating_seq_.get_relaxed()) {
+    size_t min_seq = barrier_.min_sequence();
+    stats_.record_occupancy(std::min(seq - min_seq, capacity()));
+    if (wrap_point > min_seq) {
+      size_t wait_count = 0;
+      auto const start = WaitStats::Clock::now();
+      do {
+        wait_strategy_(wait_count++);
+      } while (wrap_point > (min_seq = barrier_.min_sequence()));
+      stats_.record_wait(wait_count, WaitStats::Clock::now() - start);
+    }
     gating_seq_.set(min_seq);
   }
 }
@@ -10,11 +10,12 @@
 #include <functional>
 #include "sequence.hpp"
 #include "processor_barrier.hpp"
+#include "telemetry.hpp"
 
 namespace ku { namespace fusion {
 
 /// Disruptor ring buffer, specifically made for epoll events
-//  Only one writer is allowed (which is the epoll poller)
+//  Only one writer is allowed (which is the epoll poller), read by EventProcessor
 class EventBuffer
 {
   using Events = std::vector<epoll_event>;
@@ -42,21 +43,27 @@ public:
 
   void claim(size_t seq);
   void publish(size_t seq);
+  // For processors, waits until seq is published, see ProcessorBarrier::wait_for
+  size_t wait_for(size_t seq) { return barrier_.wait_for(published_seq_, seq); }
+  // For the writer, waits with the wait strategy until processors are done with the slot
+  // of seq
+  void wait_for_seq(size_t seq);
+
+  // For monitoring threads, reads the published and processor sequences only
+  RingTelemetry telemetry() const;
 
   // the max sequence that can be claimed without clashing with processors
   size_t max_usable_sequence() const;
   // the max usable sequence in the forward continous block
   size_t max_usable_block_sequence() const;
 
-private:
-  void wait_for_seq(size_t seq);
-
 private:
   size_t const mask_;
   Events events_;
   ProcessorBarrier barrier_;
   Sequence claimed_seq_, published_seq_, gating_seq_;
   std::function<void(size_t)> wait_strategy_;
+  WaitStats stats_;
 };
 
 } } // namespace ku::fusion
@@ -0,0 +1,36 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cstdint>
+#include "event_processor.hpp"
+
+namespace ku { namespace fusion {
+
+void EventProcessor::run()
+{
+  size_t next_seq = sequence_.get_relaxed() + 1;
+  for (;;) {
+    size_t const available = buffer_.wait_for(next_seq);
+    if (available < next_seq)
+      return;
+    for (; next_seq <= available; ++next_seq) {
+      epoll_event const& ev = buffer_.raw_event(next_seq);
+      if (partition(ev, count_) == index_)
+        handler_(ev);
+    }
+    sequence_.set(available);
+  }
+}
+
+size_t EventProcessor::partition(epoll_event const& ev, size_t count)
+{
+  // data.fd, or the low half of data.ptr, mixed for aligned pointers to spread too
+  uint32_t const key = ev.data.u32 * 2654435761u;
+  return (key >> 16) % count;
+}
+
+} } // namespace ku::fusion
+
@@ -0,0 +1,51 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <sys/epoll.h>
+#include <functional>
+#include "sequence.hpp"
+#include "event_buffer.hpp"
+#include "util.hpp"
+
+namespace ku { namespace fusion {
+
+// =======================================================================================
+// EventProcessor handles epoll events of an EventBuffer, on a thread of its own.
+// Processors of a buffer partition events on epoll_event::data, those of a same fd are
+// handled by one processor in order.
+// =======================================================================================
+class EventProcessor : private util::noncopyable
+{
+public:
+  using Handler = std::function<void(epoll_event const&)>;
+
+  EventProcessor(EventBuffer& buffer, Handler const& handler, size_t index, size_t count)
+    : buffer_(buffer), handler_(handler), index_(index), count_(count)
+    , sequence_(buffer.published_sequence())
+  { }
+
+  Sequence const& sequence() const { return sequence_; }
+
+  // Handles events as published, returns once the buffer barrier is alerted and all
+  // published are handled
+  void run();
+
+  static size_t partition(epoll_event const& ev, size_t count);
+
+  // Holds a cache line aligned Sequence
+  static void* operator new(size_t size) { return util::cache_aligned_new(size); }
+  static void operator delete(void* p) { util::cache_aligned_delete(p); }
+
+private:
+  EventBuffer& buffer_;
+  Handler handler_;
+  size_t const index_, count_;
+  Sequence sequence_;
+};
+
+} } // namespace ku::fusion
+
@@ -0,0 +1,513 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <endian.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "util.hpp"
+#include "io_uring_poller.hpp"
+
+namespace ku { namespace fusion { namespace io_uring {
+
+namespace {
+
+uint32_t translate_event_types(Notice const& notice)
+{
+  uint32_t event_types = 0;
+  if (notice.has_event_type(Notice::Inbound))
+    event_types |= (POLLIN | POLLPRI | POLLRDHUP);
+  if (notice.has_event_type(Notice::Outbound))
+    event_types |= POLLOUT;
+#if __BYTE_ORDER == __BIG_ENDIAN
+  event_types = event_types << 16 | event_types >> 16; // poll32_events is word-reversed
+#endif
+  return event_types;
+}
+
+void translate_events(int res, Notice& notice)
+{
+  notice.reset_events();
+  if (res < 0) {
+    notice.set_event(Notice::Error);
+    return;
+  }
+  if (res & (POLLHUP | POLLRDHUP))
+    notice.set_event(Notice::Close);
+  if (res & (POLLIN | POLLPRI))
+    notice.set_event(Notice::Read);
+  if (res & POLLOUT)
+    notice.set_event(Notice::Write);
+  if (res & (POLLERR | POLLNVAL))
+    notice.set_event(Notice::Error);
+}
+
+void* map_ring(int fd, size_t size, off_t offset)
+{
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+template <typename T>
+T* at(void* ring, unsigned offset)
+{
+  return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+} // unamed namespace
+
+bool supported()
+{
+  try {
+    Ring ring(2);
+    return true;
+  } catch (std::system_error const&) {
+    return false;
+  }
+}
+
+bool supports_multishot()
+{
+  try {
+    Ring ring(2);
+    // Multishot recv came with linux 6.0, as did IORING_OP_SEND_ZC, the probe lists opcodes
+    // only, so that one stands for it
+    size_t const size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<char> buf(size);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buf.data());
+    if (::syscall(SYS_io_uring_register, ring.raw_handle(), IORING_REGISTER_PROBE, probe, 256) < 0)
+      return false;
+    return probe->last_op >= IORING_OP_SEND_ZC
+        && (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+  } catch (std::system_error const&) {
+    return false;
+  }
+}
+
+/// Ring ///
+Ring::Ring(unsigned entries)
+  : raw_handle_(-1), sq_ring_(nullptr), sq_ring_size_(0), cq_ring_(nullptr), cq_ring_size_(0),
+    sqes_(nullptr), sqe_tail_(0), to_submit_(0)
+{
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CLAMP;
+  if ((raw_handle_ = ::syscall(SYS_io_uring_setup, entries, &params)) < 0)
+    throw std::system_error(util::errc(), "io_uring::Ring::Ring");
+  // Waiting with a timeout, and no completion dropped on overflow
+  if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+    close();
+    throw std::system_error(util::errc(ENOSYS), "io_uring::Ring::Ring");
+  }
+
+  // Before the mmaps, close() unmaps the entries by it
+  sq_entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  sq_ring_ = map_ring(raw_handle_, sq_ring_size_, IORING_OFF_SQ_RING);
+  cq_ring_ = params.features & IORING_FEAT_SINGLE_MMAP
+           ? sq_ring_ : map_ring(raw_handle_, cq_ring_size_, IORING_OFF_CQ_RING);
+  sqes_ = static_cast<io_uring_sqe*>(map_ring(raw_handle_, sq_entries_ * sizeof(io_uring_sqe),
+                                              IORING_OFF_SQES));
+  if (!sq_ring_ || !cq_ring_ || !sqes_) {
+    std::error_code const err = util::errc();
+    close();
+    throw std::system_error(err, "io_uring::Ring::Ring");
+  }
+
+  sq_mask_ = *at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_head_ = at<unsigned>(sq_ring_, params.sq_off.head);
+  sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+  sqe_tail_ = *sq_tail_;
+  // Entry n always takes slot n of the array
+  unsigned* const array = at<unsigned>(sq_ring_, params.sq_off.array);
+  for (unsigned n = 0; n < sq_entries_; ++n)
+    array[n] = n;
+  cq_mask_ = *at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+  cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+}
+
+void Ring::close()
+{
+  if (sqes_)
+    ::munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+  if (cq_ring_ && cq_ring_ != sq_ring_)
+    ::munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_)
+    ::munmap(sq_ring_, sq_ring_size_);
+  sqes_ = nullptr;
+  sq_ring_ = cq_ring_ = nullptr;
+  if (raw_handle_ >= 0)
+    ::close(raw_handle_);
+  raw_handle_ = -1;
+}
+
+io_uring_sqe* Ring::get_sqe()
+{
+  if (sq_space() == 0) {
+    submit();
+    if (sq_space() == 0)
+      throw std::system_error(util::errc(EBUSY), "io_uring::Ring::get_sqe");
+  }
+  io_uring_sqe* sqe = &sqes_[sqe_tail_++ & sq_mask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  ++to_submit_;
+  return sqe;
+}
+
+void Ring::reserve(unsigned count)
+{
+  assert(count <= sq_entries_);
+  if (sq_space() < count)
+    submit();
+}
+
+int Ring::enter(unsigned to_submit, unsigned min_complete, unsigned flags, void const* arg, size_t size)
+{
+  __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+  int const ret = ::syscall(SYS_io_uring_enter, raw_handle_, to_submit, min_complete, flags, arg, size);
+  if (ret > 0)
+    to_submit_ -= std::min(to_submit_, unsigned(ret));
+  return ret;
+}
+
+void Ring::submit()
+{
+  while (to_submit_ > 0 && enter(to_submit_, 0, 0, nullptr, 0) < 0) {
+    // Busy as completions overflowed, the caller reaps them and submits next round
+    if (errno == EBUSY || errno == EAGAIN)
+      return;
+    if (errno != EINTR)
+      throw std::system_error(util::errc(), "io_uring::Ring::submit");
+  }
+}
+
+void Ring::submit_and_wait(std::chrono::milliseconds const& timeout)
+{
+  __kernel_timespec ts;
+  io_uring_getevents_arg arg;
+  std::memset(&arg, 0, sizeof(arg));
+  unsigned flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+  if (timeout.count() >= 0) {
+    ts.tv_sec = timeout.count() / 1000;
+    ts.tv_nsec = timeout.count() % 1000 * 1000000;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+  if (enter(to_submit_, 1, flags, &arg, sizeof(arg)) < 0
+      && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN)
+    throw std::system_error(util::errc(), "io_uring::Ring::submit_and_wait");
+}
+
+/// BufferRing ///
+BufferRing::BufferRing(Ring& ring, unsigned count, size_t size)
+  : ring_(ring), count_(count), size_(size), bufs_(nullptr), data_(nullptr), tail_(0)
+{
+  if (count == 0 || count > 32768 || (count & (count - 1)))
+    throw std::system_error(util::errc(EINVAL), "io_uring::BufferRing::BufferRing");
+  bufs_size_ = count * sizeof(io_uring_buf);
+  void* p = ::mmap(nullptr, bufs_size_ + count * size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    throw std::system_error(util::errc(), "io_uring::BufferRing::BufferRing");
+  // Not through io_uring_buf_ring::bufs, its flexible array is off by 8 bytes in C++
+  bufs_ = static_cast<io_uring_buf*>(p);
+  data_ = static_cast<char*>(p) + bufs_size_;
+
+  io_uring_buf_reg reg;
+  std::memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uint64_t>(bufs_);
+  reg.ring_entries = count;
+  reg.bgid = group();
+  if (::syscall(SYS_io_uring_register, ring_.raw_handle(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    std::error_code const err = util::errc();
+    ::munmap(bufs_, bufs_size_ + count_ * size_);
+    throw std::system_error(err, "io_uring::BufferRing::BufferRing");
+  }
+  for (unsigned n = 0; n < count_; ++n)
+    recycle(n);
+}
+
+BufferRing::~BufferRing()
+{
+  io_uring_buf_reg reg;
+  std::memset(&reg, 0, sizeof(reg));
+  reg.bgid = group();
+  ::syscall(SYS_io_uring_register, ring_.raw_handle(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+  ::munmap(bufs_, bufs_size_ + count_ * size_);
+}
+
+void BufferRing::recycle(uint16_t bid)
+{
+  io_uring_buf& buf = bufs_[tail_ & (count_ - 1)];
+  buf.addr = reinterpret_cast<uint64_t>(data_ + bid * size_);
+  buf.len = size_;
+  buf.bid = bid;
+  __atomic_store_n(&bufs_[0].resv, ++tail_, __ATOMIC_RELEASE);
+}
+
+/// Notices ///
+void Notices::arm(Notice const& notice)
+{
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = notice.raw_handle();
+  sqe->poll32_events = translate_event_types(notice);
+  if (notice.has_event_type(Notice::Edge))
+    sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = notice.id();
+}
+
+bool Notices::add_notice_internal(Notice&& notice)
+{
+  assert(notice.any_event_type());
+  arm(*notices_.insert(std::move(notice)));
+  return true;
+}
+
+bool Notices::remove_notice_internal(NoticeId id)
+{
+  if (!notices_.erase(id))
+    return false;
+  // Its last completion, if any, finds no notice
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->addr = id;
+  return true;
+}
+
+bool Notices::modify_notice_internal(NoticeId id, Notice const& notice)
+{
+  Notice* notice_ptr = notices_.find(id);
+  if (!notice_ptr)
+    return false;
+  notice_ptr->set_event_handler(notice.event_handler());
+  bool const edge = notice_ptr->has_event_type(Notice::Edge);
+  notice_ptr->set_event_types(notice.event_types());
+  edge ? notice_ptr->set_event_type(Notice::Edge) : notice_ptr->reset_event_type(Notice::Edge);
+  // A oneshot poll completed and not reaped yet isn't found, it is rearmed with these
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->addr = id;
+  sqe->len = IORING_POLL_UPDATE_EVENTS | (edge ? IORING_POLL_ADD_MULTI : 0);
+  sqe->poll32_events = translate_event_types(*notice_ptr);
+  return true;
+}
+
+/// PollLoop ///
+PollLoop::PollLoop(unsigned entries)
+  : ring_(entries), notices_(ring_), buffer_count_(256), buffer_size_(4096)
+{
+}
+
+void PollLoop::set_buffers(unsigned count, size_t size)
+{
+  assert(!buffers_);
+  buffer_count_ = count;
+  buffer_size_ = size;
+}
+
+PollLoop::OpId PollLoop::new_op(Op::Kind kind, int fd)
+{
+  uint32_t slot;
+  if (free_ops_.empty()) {
+    assert(ops_.size() < UINT32_MAX);
+    slot = ops_.size();
+    ops_.emplace_back();
+    ops_.back().generation = 0;
+  } else {
+    slot = free_ops_.back();
+    free_ops_.pop_back();
+  }
+  Op& op = ops_[slot];
+  op.generation = NoticeSlab::next_generation(op.generation);
+  op.id = OpId(op.generation) << 32 | slot;
+  op.kind = kind;
+  op.cancelled = false;
+  op.fd = fd;
+  op.pending = 0;
+  op.result = 0;
+  return op.id;
+}
+
+void PollLoop::free_op(OpId id)
+{
+  Op& op = ops_[slot_of(id)];
+  op.id = 0;
+  op.accept = nullptr;
+  op.recv = nullptr;
+  op.send = nullptr;
+  free_ops_.push_back(slot_of(id));
+}
+
+PollLoop::OpId PollLoop::accept(int listen_fd, AcceptHandler const& handler)
+{
+  OpId const id = new_op(Op::Accept, listen_fd);
+  find_op(id)->accept = handler;
+  arm_accept(id);
+  return id;
+}
+
+void PollLoop::arm_accept(OpId id)
+{
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = find_op(id)->fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+  sqe->user_data = user_data(id);
+}
+
+PollLoop::OpId PollLoop::recv(int fd, RecvHandler const& handler)
+{
+  if (!buffers_)
+    buffers_.reset(new BufferRing(ring_, buffer_count_, buffer_size_));
+  OpId const id = new_op(Op::Recv, fd);
+  find_op(id)->recv = handler;
+  arm_recv(id);
+  return id;
+}
+
+void PollLoop::arm_recv(OpId id)
+{
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = find_op(id)->fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffers_->group();
+  sqe->user_data = user_data(id);
+}
+
+PollLoop::OpId PollLoop::send(int fd, std::vector<iovec> const& bufs, SendHandler const& handler)
+{
+  if (bufs.empty() || bufs.size() > ring_.entries())
+    throw std::system_error(util::errc(EINVAL), "io_uring::PollLoop::send");
+  OpId const id = new_op(Op::Send, fd);
+  Op& op = *find_op(id);
+  op.send = handler;
+  op.pending = bufs.size();
+  // A chain split over two submits would be two chains
+  ring_.reserve(bufs.size());
+  for (size_t n = 0; n < bufs.size(); ++n) {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(bufs[n].iov_base);
+    sqe->len = bufs[n].iov_len;
+    // A short send is retried till all is sent, a plain one would complete and keep the
+    // chain going, leaving a gap in the stream
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    if (n + 1 < bufs.size())
+      sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = user_data(id);
+  }
+  return id;
+}
+
+void PollLoop::cancel(OpId id)
+{
+  // Freed on its last completion, a late cancel finds no op, or a newer generation
+  Op* op = find_op(id);
+  if (!op || op->cancelled)
+    return;
+  op->cancelled = true;
+  io_uring_sqe* sqe = ring_.get_sqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->addr = user_data(id);
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+}
+
+bool PollLoop::loop(std::chrono::milliseconds timeout)
+{
+  while (!quit_.load(std::memory_order_acquire)) {
+    notices_.apply_updates();
+    ring_.submit_and_wait(timeout);
+    ring_.reap([this](io_uring_cqe const& cqe) { complete(cqe); });
+  }
+  ring_.submit();
+  return true;
+}
+
+void PollLoop::complete(io_uring_cqe const& cqe)
+{
+  if (cqe.user_data & OpTag)
+    complete_op(cqe.user_data & ~OpTag, cqe);
+  else if (cqe.user_data != 0) // 0 for removes and cancels
+    complete_notice(cqe);
+}
+
+void PollLoop::complete_notice(io_uring_cqe const& cqe)
+{
+  NoticeId const id = cqe.user_data;
+  Notice* notice = notices_.find_notice(id);
+  if (!notice) // stale, its notice is gone
+    return;
+  translate_events(cqe.res, *notice);
+  dispatch(*notice, notices_);
+  // Oneshot, or a multishot the kernel ended
+  if (!(cqe.flags & IORING_CQE_F_MORE) && cqe.res >= 0 && (notice = notices_.find_notice(id)))
+    notices_.arm(*notice);
+}
+
+void PollLoop::complete_op(OpId id, io_uring_cqe const& cqe)
+{
+  Op* op_ptr = find_op(id);
+  if (!op_ptr) // none after the last completion
+    return;
+  Op& op = *op_ptr;
+  bool const more = cqe.flags & IORING_CQE_F_MORE;
+  switch (op.kind) {
+  case Op::Accept:
+    if (!op.cancelled && (cqe.res >= 0 || !more))
+      op.accept(cqe.res);
+    else if (op.cancelled && cqe.res >= 0) // accepted as it was cancelled
+      ::close(cqe.res);
+    if (more)
+      return;
+    if (!op.cancelled && cqe.res >= 0)
+      return arm_accept(id);
+    break;
+  case Op::Recv:
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+      uint16_t const bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+      if (!op.cancelled)
+        op.recv(cqe.res, buffers_->buffer(bid));
+      buffers_->recycle(bid);
+    }
+    if (more)
+      return;
+    // Ended as the buffers ran out, they are back now
+    if (!op.cancelled && (cqe.res > 0 || cqe.res == -ENOBUFS))
+      return arm_recv(id);
+    if (!op.cancelled)
+      op.recv(cqe.res, nullptr);
+    break;
+  case Op::Send:
+    // Sends after a failed one are cancelled, the first error is reported
+    if (op.result >= 0)
+      op.result = cqe.res < 0 ? cqe.res : op.result + cqe.res;
+    if (--op.pending > 0)
+      return;
+    if (!op.cancelled)
+      op.send(op.result);
+    break;
+  }
+  free_op(id);
+}
+
+} } } // namespace ku::fusion::io_uring
+
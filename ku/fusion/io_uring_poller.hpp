@@ -0,0 +1,240 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <cassert>
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <vector>
+#include "notice.hpp"
+#include "notice_board.hpp"
+#include "notice_slab.hpp"
+#include "poll_loop.hpp"
+
+namespace ku { namespace fusion { namespace io_uring {
+
+// io_uring works here, the kernel has it and no seccomp policy forbids it, enough for
+// notices
+bool supported();
+// PollLoop::accept() and recv() work too, multishot and provided buffer rings
+bool supports_multishot();
+
+// =======================================================================================
+// io_uring::Ring maps the submission and completion queues of an io_uring, by raw
+// syscalls, for one thread. Entries taken by get_sqe() reach the kernel on the next
+// submit(), many per syscall.
+// =======================================================================================
+class Ring : private util::noncopyable
+{
+public:
+  explicit Ring(unsigned entries);
+  ~Ring() { close(); }
+
+  // A zeroed entry, submits the pending ones first if the queue is full
+  io_uring_sqe* get_sqe();
+  // Submits pending ones first unless count entries are free, for a linked chain
+  void reserve(unsigned count);
+  void submit();
+  // Submits and waits for a completion till timeout, -1 waits forever
+  void submit_and_wait(std::chrono::milliseconds const& timeout);
+  // Calls f(cqe) for each completion, returns the count
+  template <typename F>
+  unsigned reap(F f);
+
+  unsigned entries() const { return sq_entries_; }
+  int raw_handle() const { return raw_handle_; }
+
+private:
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags, void const* arg, size_t size);
+  unsigned sq_space() const
+  { return sq_entries_ - (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE)); }
+  void close();
+
+private:
+  int raw_handle_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  io_uring_sqe* sqes_;
+  unsigned sq_entries_, sq_mask_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned cq_mask_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  io_uring_cqe* cqes_;
+  unsigned sqe_tail_;  // taken by get_sqe(), stored to sq_tail_ on submit
+  unsigned to_submit_;
+};
+
+template <typename F>
+unsigned Ring::reap(F f)
+{
+  unsigned const head = *cq_head_; // only we move it
+  unsigned const tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (unsigned n = head; n != tail; ++n) {
+    io_uring_cqe const cqe = cqes_[n & cq_mask_];
+    // Frees the entry before the handler, which may submit more
+    __atomic_store_n(cq_head_, n + 1, __ATOMIC_RELEASE);
+    f(cqe);
+  }
+  return tail - head;
+}
+
+// =======================================================================================
+// Provided buffers, registered as a ring of group 0, the kernel picks one for each
+// multishot recv completion. They are given back once the handler returns.
+// =======================================================================================
+class BufferRing : private util::noncopyable
+{
+public:
+  // count is a power of two up to 32768
+  BufferRing(Ring& ring, unsigned count, size_t size);
+  ~BufferRing();
+
+  uint16_t group() const { return 0; }
+  char const* buffer(uint16_t bid) const { return data_ + bid * size_; }
+  void recycle(uint16_t bid);
+
+private:
+  Ring& ring_;
+  unsigned const count_;
+  size_t const size_;
+  io_uring_buf* bufs_; // io_uring_buf_ring, its tail overlays bufs_[0].resv
+  size_t bufs_size_;
+  char* data_;
+  uint16_t tail_;
+};
+
+class PollLoop;
+
+// =======================================================================================
+// io_uring::Notices arms a poll for each notice, its user data the notice id. Edge
+// notices get a multishot poll, the others a oneshot one rearmed after dispatch, which
+// polls the fd right away, level triggered as epoll. Edge is fixed when added.
+// =======================================================================================
+class Notices : public NoticeBoard
+              , private util::noncopyable
+{
+  friend class PollLoop;
+
+public:
+  explicit Notices(Ring& ring) : ring_(ring) { }
+  virtual ~Notices() { }
+
+  using NoticeBoard::apply_updates;
+
+private:
+  virtual bool add_notice_internal(Notice&& notice);
+  virtual bool remove_notice_internal(NoticeId id);
+  virtual bool modify_notice_internal(NoticeId id, Notice const& notice);
+  virtual Notice* find_notice(NoticeId id) { return notices_.find(id); }
+  virtual NoticeId next_id() { return notices_.allocate(); }
+
+  void arm(Notice const& notice);
+
+private:
+  Ring& ring_;
+  NoticeSlab notices_;
+};
+
+// =======================================================================================
+// io_uring::PollLoop is the main loop using io_uring. One syscall per round submits the
+// queued polls and operations and waits for completions.
+// Besides notices, it runs completion style socket operations, for the loop thread:
+//   accept()  a multishot accept, a completion per connection
+//   recv()    a multishot recv into the provided buffers, no syscall per read
+//   send()    sends of a list of buffers, linked so they go out in order and whole
+// Multishot accept and provided buffers need linux 5.19, multishot recv 6.0, see
+// supports_multishot().
+// =======================================================================================
+class PollLoop : public fusion::PollLoop
+               , private util::noncopyable
+{
+public:
+  // Generation in the high 32 bits and slot in the low ones, as notice ids, so the id of
+  // a finished op never reaches the one reusing its slot
+  using OpId = uint64_t;
+  // An accepted fd, or -errno once the accept stops
+  using AcceptHandler = std::function<void(int)>;
+  // Bytes received and the data, valid during the call only, 0 at end of stream, or
+  // -errno once the recv stops
+  using RecvHandler = std::function<void(int, char const*)>;
+  // Bytes sent, or -errno of the first failed send
+  using SendHandler = std::function<void(int)>;
+
+  explicit PollLoop(unsigned entries = 256);
+  ~PollLoop() { }
+
+  virtual NoticeBoard& notices() { return notices_; }
+
+  // Provided buffers, before the first recv(), count is a power of two
+  void set_buffers(unsigned count, size_t size);
+
+  OpId accept(int listen_fd, AcceptHandler const& handler);
+  OpId recv(int fd, RecvHandler const& handler);
+  // bufs must stay till the handler is called
+  OpId send(int fd, std::vector<iovec> const& bufs, SendHandler const& handler);
+  // No more handler calls for the op, nothing if it is finished
+  void cancel(OpId id);
+
+private:
+  virtual bool loop(std::chrono::milliseconds timeout);
+
+  struct Op
+  {
+    enum Kind : uint8_t { Accept, Recv, Send };
+
+    OpId id; // 0 once finished
+    uint32_t generation;
+    Kind kind;
+    bool cancelled;
+    int fd;
+    unsigned pending; // completions of a send chain
+    int result;
+    AcceptHandler accept;
+    RecvHandler recv;
+    SendHandler send;
+  };
+
+  // User data of ops have the top bit set, notice ids never do
+  static uint64_t const OpTag = uint64_t(1) << 63;
+  static uint64_t user_data(OpId id) { return id | OpTag; }
+  static uint32_t slot_of(OpId id) { return static_cast<uint32_t>(id); }
+
+  // nullptr if the op is finished
+  Op* find_op(OpId id)
+  {
+    uint32_t const slot = slot_of(id);
+    return slot < ops_.size() && ops_[slot].id == id ? &ops_[slot] : nullptr;
+  }
+  OpId new_op(Op::Kind kind, int fd);
+  void free_op(OpId id);
+  void arm_accept(OpId id);
+  void arm_recv(OpId id);
+  void complete(io_uring_cqe const& cqe);
+  void complete_notice(io_uring_cqe const& cqe);
+  void complete_op(OpId id, io_uring_cqe const& cqe);
+
+private:
+  Ring ring_;
+  Notices notices_;
+  std::deque<Op> ops_; // stay put while their handlers run
+  std::vector<uint32_t> free_ops_;
+  unsigned buffer_count_;
+  size_t buffer_size_;
+  std::unique_ptr<BufferRing> buffers_;
+};
+
+} } } // namespace ku::fusion::io_uring
+
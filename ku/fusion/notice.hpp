@@ -17,7 +17,8 @@
 
 namespace ku { namespace fusion {
 
-using NoticeId = uint32_t;
+// Boards indexing notices by id pack a slot and a generation in it, see NoticeSlab
+using NoticeId = uint64_t;
 
 // =======================================================================================
 // Notice is the link among handle, events and event handlers.
@@ -40,22 +41,29 @@ public:
 
   Notice() : raw_handle_(0), id_(0) { } // TODO protected?
   Notice(int raw_handle, EventHandler event_handler)
-    : raw_handle_(raw_handle), id_(++next_notice_id), event_handler_(event_handler) { }
+    : raw_handle_(raw_handle), id_(next_id()), event_handler_(event_handler) { }
+  Notice(int raw_handle, EventHandler event_handler, NoticeId id)
+    : raw_handle_(raw_handle), id_(id), event_handler_(event_handler) { }
 
   Notice& operator = (Notice&& notice);
   Notice(Notice&& notice) { *this = std::move(notice); }
 
+  // Ids of boards not assigning their own
+  static NoticeId next_id() { return ++next_notice_id; }
+
   NoticeId id() const { return id_; }
   int raw_handle() const { return raw_handle_; }
 
   EventTypes const& event_types() const { return event_types_; }
   void set_event_types(EventTypes const& evts) { event_types_ = evts; }
   void set_event_type(EventType et) { event_types_.set(et); }
+  void reset_event_type(EventType et) { event_types_.reset(et); }
   bool has_event_type(EventType et) const { return event_types_.test(et); }
   bool any_event_type() const { return event_types_.any(); }
 
   Events const& events() const { return events_; }
   void set_event(Event ev) { events_.set(ev); }
+  void reset_events() { events_.reset(); }
   bool has_event(Event ev) const { return events_.test(ev); }
   bool any_event() const { return events_.any(); }
 
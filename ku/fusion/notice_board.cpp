@@ -37,7 +37,7 @@ NoticeId NoticeBoard::add_notice(int raw_handle, std::initializer_list<Notice::E
 {
   pending_updates_ = true;
   std::lock_guard<std::mutex> _(mutex_);
-  update_list_.emplace_back(NoticeId(0), Notice(raw_handle, event_handler));
+  update_list_.emplace_back(NoticeId(0), Notice(raw_handle, event_handler, next_id()));
   for (Notice::EventType event_type : event_types)
     update_list_.back().notice.set_event_type(event_type);
   return update_list_.back().notice.id();
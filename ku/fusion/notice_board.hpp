@@ -43,6 +43,10 @@ public:
 protected:
   void apply_updates();
 
+  // Id of a notice to add, called by add_notice on the adding thread. Boards indexing
+  // notices by id override it, the default counts up.
+  virtual NoticeId next_id() { return Notice::next_id(); }
+
 private:
   NoticeId add_notice(int raw_handle, std::initializer_list<Notice::EventType> const& event_types,
       Notice::EventHandler const& event_handler);
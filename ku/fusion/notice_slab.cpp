@@ -0,0 +1,66 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cassert>
+#include "notice_slab.hpp"
+
+namespace ku { namespace fusion {
+
+NoticeId NoticeSlab::allocate()
+{
+  std::lock_guard<std::mutex> _(mutex_);
+  uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = generations_.size();
+    generations_.push_back(0);
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  uint32_t const generation = generations_[slot] = next_generation(generations_[slot]);
+  return NoticeId(generation) << 32 | slot;
+}
+
+Notice* NoticeSlab::insert(Notice&& notice)
+{
+  uint32_t const slot = slot_of(notice.id());
+  assert(generation_of(notice.id()) != 0);
+  if (slot >= notices_.size())
+    notices_.resize(slot + 1);
+  assert(notices_[slot].id() == 0);
+  notices_[slot] = std::move(notice);
+  ++size_;
+  return &notices_[slot];
+}
+
+bool NoticeSlab::erase(NoticeId id)
+{
+  if (!find(id))
+    return false;
+  notices_[slot_of(id)] = Notice();
+  --size_;
+  release(id);
+  return true;
+}
+
+void NoticeSlab::release(NoticeId id)
+{
+  std::lock_guard<std::mutex> _(mutex_);
+  free_slots_.push_back(slot_of(id));
+}
+
+void NoticeSlab::clear()
+{
+  for (Notice& notice : notices_) {
+    if (notice.id())
+      release(notice.id());
+    notice = Notice();
+  }
+  size_ = 0;
+}
+
+} } // namespace ku::fusion
+
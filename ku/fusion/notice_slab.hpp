@@ -0,0 +1,64 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "notice.hpp"
+
+namespace ku { namespace fusion {
+
+// =======================================================================================
+// NoticeSlab keeps notices in a vector indexed by the slot in their id, the low 32 bits.
+// The high 32 bits are the generation of the slot, bumped each time it is handed out, so
+// an id of a removed notice never finds the one reusing its slot. Generations stay below
+// 2^31, the top bit of an id is left for backends to tag user data of their own.
+// Ids are allocated by threads adding notices, the rest is for the loop thread only.
+// =======================================================================================
+class NoticeSlab : private util::noncopyable
+{
+public:
+  NoticeSlab() = default;
+  ~NoticeSlab() = default;
+
+  static uint32_t const MaxGeneration = 0x7fffffff;
+
+  static uint32_t slot_of(NoticeId id) { return static_cast<uint32_t>(id); }
+  static uint32_t generation_of(NoticeId id) { return static_cast<uint32_t>(id >> 32); }
+  // Wraps to 1, 0 is not an id
+  static uint32_t next_generation(uint32_t generation)
+  { return generation < MaxGeneration ? generation + 1 : 1; }
+
+  // Any thread, a free slot with its next generation, never 0
+  NoticeId allocate();
+
+  // Stores the notice at the slot of its id, from allocate()
+  Notice* insert(Notice&& notice);
+  // nullptr if the id is stale or unknown
+  Notice* find(NoticeId id)
+  {
+    uint32_t const slot = slot_of(id);
+    return slot < notices_.size() && notices_[slot].id() == id ? &notices_[slot] : nullptr;
+  }
+  // Frees the slot for allocate(), false if the id is stale or unknown
+  bool erase(NoticeId id);
+  // Frees the slot of an id never inserted, as the add failed
+  void release(NoticeId id);
+
+  size_t size() const { return size_; }
+  void clear();
+
+private:
+  std::vector<Notice> notices_;
+  size_t size_ = 0;
+  std::mutex mutex_; // guards generations_ and free_slots_, allocate() is called by adders
+  std::vector<uint32_t> generations_;
+  std::vector<uint32_t> free_slots_;
+};
+
+} } // namespace ku::fusion
+
@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/uio.h>
+#include <sys/socket.h>
 #include <netdb.h>
 #include <system_error>
 #include "../util.hpp"
@@ -33,6 +34,14 @@ struct Socket
     throw std::system_error(util::errc(), "ops::Socket::create");
   }
 
+  // Sockets of the same user bound to one address each get a share of its connections
+  static inline void reuse_port(Handle<Socket>& h)
+  {
+    int const on = 1;
+    if (::setsockopt(h.raw_handle(), SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
+      throw std::system_error(util::errc(), "ops::Socket::reuse_port");
+  }
+
   static inline void bind(Handle<Socket>& h, SocketEndpoint const& endpoint)
   {
     if (::bind(h.raw_handle(), &endpoint.sockaddress(), endpoint.sockaddr_size()) == -1)
@@ -62,6 +71,19 @@ struct Socket
     return socket_handle;
   }
 
+  static inline SocketEndpoint local_endpoint(Handle<Socket> const& h)
+  {
+    sockaddr_storage addr;
+    socklen_t addr_len = sizeof(sockaddr_storage);
+    if (::getsockname(h.raw_handle(), reinterpret_cast<sockaddr*>(&addr), &addr_len) == -1)
+      throw std::system_error(util::errc(), "ops::Socket::local_endpoint");
+    if (addr.ss_family == AF_INET)
+      return SocketEndpoint(*reinterpret_cast<sockaddr_in*>(&addr));
+    if (addr.ss_family == AF_INET6)
+      return SocketEndpoint(*reinterpret_cast<sockaddr_in6*>(&addr));
+    return SocketEndpoint(*reinterpret_cast<sockaddr_un*>(&addr));
+  }
+
   static void connect(Handle<Socket>& h, SocketEndpoint const& endpoint)
   {
     if (::connect(h.raw_handle(), &endpoint.sockaddress(), endpoint.sockaddr_size()) == -1)
@@ -5,6 +5,7 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <atomic>
 #include "notice_board.hpp"
 
 namespace ku { namespace fusion {
@@ -14,7 +15,8 @@ class PollLoop
 public:
   PollLoop() : quit_(false) { }
 
-  void quit() { quit_ = true; } // TODO quit should take care of timeout=-1
+  // From any thread, the loop sees it once its poll returns
+  void quit() { quit_.store(true, std::memory_order_release); }
   virtual NoticeBoard& notices() = 0;
 
   bool operator () (std::chrono::milliseconds timeout = std::chrono::milliseconds(-1))
@@ -26,7 +28,7 @@ private:
 protected:
   void dispatch(Notice& notice, NoticeBoard& notice_board);
 
-  bool quit_;
+  std::atomic_bool quit_;
 };
 
 } } // namespace ku::fusion
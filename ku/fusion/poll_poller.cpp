@@ -25,6 +25,7 @@ void translate_event_types(int event_types, Notice& notice)
 
 void translate_events(pollfd const& ev, Notice& notice)
 {
+  notice.reset_events();
   if (ev.revents & (POLLHUP | POLLRDHUP))
     notice.set_event(Notice::Close);
   if (ev.revents & (POLLIN | POLLPRI | POLLRDHUP))
@@ -41,94 +42,81 @@ void Events::clear()
 {
   active_count_ = 0;
   events_.clear();
+  ids_.clear();
+  positions_.clear();
   notices_.clear();
 }
 
 Notice* Events::find_notice(pollfd const& ev)
 {
-  // TODO
+  int const pos = position(ev.fd);
+  return pos < 0 ? nullptr : notices_.find(ids_[pos]);
 }
 
 bool Events::add_notice_internal(Notice&& notice)
 {
   assert(notice.any_event_type());
-  size_t evt_count = notices_.size();
-  int raw_handle = notice.raw_handle();
-  auto res = notices_.insert(std::make_pair(raw_handle,
-                                            std::make_pair(std::move(notice), evt_count)));
-  if (res.second) {
-    if (evt_count >= events_.size())
-      resize(evt_count + evt_count / 2);
-    pollfd& ev = events_[evt_count];
-    Notice* ch_ptr = &res.first->second.first;
-    ev.fd = ch_ptr->raw_handle();
-    ev.events = translate_event_types(*ch_ptr);
-    return true;
+  int const fd = notice.raw_handle();
+  if (fd < 0 || position(fd) >= 0) {
+    notices_.release(notice.id());
+    return false;
   }
-  return false;
+  if (size_t(fd) >= positions_.size())
+    positions_.resize(fd + 1, -1);
+  positions_[fd] = events_.size();
+
+  pollfd ev;
+  ev.fd = fd;
+  ev.events = translate_event_types(notice);
+  ev.revents = 0;
+  events_.push_back(ev);
+  ids_.push_back(notice.id());
+  notices_.insert(std::move(notice));
+  return true;
 }
 
 bool Events::remove_notice_internal(NoticeId id)
 {
-  auto find = notices_.find(id);
-  if (notices_.end() != find) {
-    assert(find->second.first.id() == id);
-    size_t idx = find->second.second;
-    assert(0 <= idx && idx < events_.size());
-    pollfd& ev = events_[idx];
-    ev.fd = 0;
-    notices_.erase(find);
-    compress(idx);
-    return true;
+  Notice* notice = notices_.find(id);
+  if (!notice)
+    return false;
+  int const fd = notice->raw_handle();
+  size_t const pos = positions_[fd];
+  assert(ids_[pos] == id);
+  // Move the last pollfd to the hole
+  size_t const last = events_.size() - 1;
+  if (pos != last) {
+    events_[pos] = events_[last];
+    ids_[pos] = ids_[last];
+    positions_[events_[pos].fd] = pos;
   }
-  return false;
+  events_.pop_back();
+  ids_.pop_back();
+  positions_[fd] = -1;
+  notices_.erase(id);
+  return true;
 }
 
 bool Events::modify_notice_internal(NoticeId id, Notice const& notice)
 {
-  auto find = notices_.find(id);
-  if (notices_.end() != find) {
-    size_t idx = find->second.second;
-    assert(0 <= idx && idx < events_.size());
-    pollfd& ev = events_[idx];
-    assert(ev.fd == notice.raw_handle());
-    ev.events = translate_event_types(notice);
-    find->second.first.set_event_types(notice.event_types());
-    find->second.first.set_event_handler(notice.event_handler());
-    return true;
-  }
-  return false;
-}
-
-Notice* Events::find_notice(NoticeId id)
-{
-  auto find = notices_.find(id);
-  return notices_.end() == find ? nullptr : &find->second.first;
-}
-
-void Events::compress(size_t idx)
-{
-  size_t evt_count = notices_.size();
-  if (idx != evt_count) {
-    // Move the last pollfd in events_ to the 'hole' in idx
-    events_[idx] = events_[evt_count];
-    events_[evt_count].fd = 0;
-    auto find = notices_.find(events_[idx].fd);
-    assert(find != notices_.end());
-    find->second.second = idx;
-  }
-  if (events_.size() > Events::InitialCapacity && evt_count < events_.size() / 2)
-    events_.resize(evt_count + evt_count / 2);
+  Notice* notice_ptr = notices_.find(id);
+  if (!notice_ptr)
+    return false;
+  events_[positions_[notice_ptr->raw_handle()]].events = translate_event_types(notice);
+  notice_ptr->set_event_types(notice.event_types());
+  notice_ptr->set_event_handler(notice.event_handler());
+  return true;
 }
 
 /// Poller ///
 //
 Events& poll(Events& evts, std::chrono::milliseconds const& timeout)
 {
-  int event_num = ::poll(evts.raw_events(), evts.notices_.size(), timeout.count());
-  if (event_num == -1) { // TODO EINTR
+  int event_num = ::poll(evts.raw_events(), evts.events_.size(), timeout.count());
+  if (event_num == -1) {
     evts.set_active_count(0);
-    throw std::system_error(util::errc(), "poll::poll");
+    if (errno != EINTR)
+      throw std::system_error(util::errc(), "poll::poll");
   } else {
     evts.set_active_count(util::implicit_cast<unsigned>(event_num));
   }
@@ -139,17 +127,21 @@ Events& poll(Events& evts, std::chrono::milliseconds const& timeout)
 //
 bool PollLoop::loop(std::chrono::milliseconds timeout)
 {
-  while (!quit_) {
+  while (!quit_.load(std::memory_order_acquire)) {
     events_.apply_updates();
     poll(events_, timeout);
-  
-    for (unsigned i = 0; i < events_.events_count(); ++i) {
+
+    // Handlers only queue updates, events_ stays put till the next round
+    unsigned ready = events_.active_count();
+    for (unsigned i = 0; ready > 0 && i < events_.events_count(); ++i) {
       pollfd const& ev = events_.raw_event(i);
       if (ev.revents == 0)
         continue;
-      Notice* notice = events_.find_notice(ev);
-      translate_events(ev, *notice);
-      dispatch(*notice, events_);
+      --ready;
+      if (Notice* notice = events_.find_notice(ev)) {
+        translate_events(ev, *notice);
+        dispatch(*notice, events_);
+      }
     }
   }
   return true;
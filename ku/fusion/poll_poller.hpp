@@ -3,31 +3,38 @@
 #include <vector>
 #include <system_error>
 #include <chrono>
-#include <unordered_map>
 #include "notice.hpp"
 #include "notice_board.hpp"
+#include "notice_slab.hpp"
 #include "poll_loop.hpp"
 
 namespace ku { namespace fusion { namespace poll {
 
+// =======================================================================================
+// poll::Events keeps the pollfds of its notices packed, poll(2) scans only live ones, and
+// a parallel array of their ids. An fd-indexed table maps a ready pollfd back to its
+// position, so dispatch and removal are O(1), removal moves the last pollfd in the hole.
+// Notices are in a NoticeSlab, as epoll::Notices.
+// =======================================================================================
 class Events : public NoticeBoard
              , private util::noncopyable
 {
   friend Events& poll(Events&, std::chrono::milliseconds const&);
   static const size_t InitialCapacity = 16;
 
-  using EventList = std::vector<pollfd>;
-  // Mapping NoticeId --> (Notice, index in events_)
-  using NoticeMap = std::unordered_map<NoticeId, std::pair<Notice, size_t>>;
-
 public:
-  Events(size_t capacity = InitialCapacity) : events_(capacity) { clear(); }
+  Events(size_t capacity = InitialCapacity) : active_count_(0)
+  {
+    events_.reserve(capacity);
+    ids_.reserve(capacity);
+  }
   virtual ~Events() { }
 
   pollfd const& raw_event(unsigned n) const { return events_[n]; }
   unsigned active_count() const { return active_count_; }
-  unsigned events_count() const { return notices_.size(); }
+  unsigned events_count() const { return events_.size(); }
 
+  // The notice of a pollfd of this set, nullptr if removed
   Notice* find_notice(pollfd const& ev);
 
   using NoticeBoard::apply_updates;
@@ -36,21 +43,24 @@ private:
   virtual bool add_notice_internal(Notice&& notice);
   virtual bool remove_notice_internal(NoticeId id);
   virtual bool modify_notice_internal(NoticeId id, Notice const& notice);
-  virtual Notice* find_notice(NoticeId id);
+  virtual Notice* find_notice(NoticeId id) { return notices_.find(id); }
+  virtual NoticeId next_id() { return notices_.allocate(); }
 
-  bool remove_notice_internal(int fd);
+  // Position of fd in events_, -1 if none
+  int position(int fd) const
+  { return 0 <= fd && size_t(fd) < positions_.size() ? positions_[fd] : -1; }
 
-  pollfd* raw_events() { return &*events_.begin(); }
+  pollfd* raw_events() { return events_.data(); }
   void set_active_count(unsigned n) { active_count_ = n; }
 
   void clear();
-  void compress(size_t idx);
-  void resize(size_t size) { events_.resize(size); }
 
 private:
   unsigned active_count_;
-  EventList events_;
-  NoticeMap notices_;
+  std::vector<pollfd> events_;
+  std::vector<NoticeId> ids_;  // of events_[n]
+  std::vector<int> positions_; // by fd
+  NoticeSlab notices_;
 };
 
 void translate_events(pollfd const& ev, Notice& notice);
@@ -4,23 +4,77 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <cassert>
 #include <system_error>
-#include <thread>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include "poller.hpp"
 #include "util.hpp"
 
 namespace ku { namespace fusion {
 
 Poller::Poller(int flags, size_t buf_size)
-  : event_buffer_(buf_size), active_count_(0), quit_(false)
+  : event_buffer_(buf_size), quit_(false)
 {
   if ((raw_handle_ = epoll_create1(flags)) == -1)
     throw std::system_error(util::errc(), "Poller::Poller");
+  if ((wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+    int const err = errno;
+    ::close(raw_handle_);
+    throw std::system_error(util::errc(err), "Poller::Poller");
+  }
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = WakeupData;
+  if (!add_event(wakeup_fd_, &ev)) {
+    int const err = errno;
+    ::close(wakeup_fd_);
+    ::close(raw_handle_);
+    throw std::system_error(util::errc(err), "Poller::Poller");
+  }
+}
+
+Poller::~Poller()
+{
+  quit_loop();
+  join();
+  ::close(wakeup_fd_);
+  ::close(raw_handle_);
+}
+
+void Poller::start(size_t count, Handler const& handler)
+{
+  assert(processors_.empty() && count > 0);
+  for (size_t n = 0; n < count; ++n) {
+    processors_.emplace_back(new EventProcessor(event_buffer_, handler, n, count));
+    event_buffer_.barrier().add_processor(*processors_.back());
+  }
+  for (auto const& processor : processors_) {
+    EventProcessor* p = processor.get();
+    threads_.emplace_back([p]() { p->run(); });
+  }
+}
+
+void Poller::quit_loop()
+{
+  quit_.store(true, std::memory_order_release);
+  uint64_t const one = 1;
+  ssize_t written = ::write(wakeup_fd_, &one, sizeof(one));
+  (void)written; // EAGAIN only if a wakeup is pending already
+  event_buffer_.barrier().alert();
+}
+
+void Poller::join()
+{
+  for (auto& thread : threads_)
+    if (thread.joinable())
+      thread.join();
 }
 
 void Poller::loop(std::chrono::milliseconds const& timeout)
 {
-  while (!quit_)
+  assert(!processors_.empty());
+  while (!quit_.load(std::memory_order_acquire))
     poll(timeout);
 }
 
@@ -46,20 +100,32 @@ bool Poller::modify_event(int raw_fd, epoll_event* event)
 
 void Poller::poll(std::chrono::milliseconds const& timeout)
 {
-  size_t begin_seq = event_buffer_.published_sequence() + 1;
-  epoll_event* free_event_begin = &event_buffer_.raw_event(begin_seq);
-  size_t next_seq;
-  while ((next_seq = event_buffer_.max_usable_block_sequence()) < begin_seq)
-    std::this_thread::yield(); // TODO wait strategy
+  size_t const begin_seq = event_buffer_.published_sequence() + 1;
+  event_buffer_.wait_for_seq(begin_seq);
+  // epoll_wait fills a continous block, up to the ring end or the slowest processor
+  size_t const end_seq = event_buffer_.max_usable_block_sequence();
+  event_buffer_.claim(end_seq);
 
-  event_buffer_.claim(next_seq);
-  int event_num = ::epoll_wait(raw_handle_, free_event_begin, next_seq - begin_seq + 1,
-                               timeout.count());
-  if (event_num > 0) {
-    event_buffer_.publish(begin_seq + event_num - 1);
-  } else if (event_num == -1) { // TODO EINTR
+  epoll_event* events = &event_buffer_.raw_event(begin_seq);
+  int event_num = ::epoll_wait(raw_handle_, events, end_seq - begin_seq + 1, timeout.count());
+  if (event_num == -1) {
+    if (errno == EINTR)
+      return;
     throw std::system_error(util::errc(), "Poller::poll");
   }
+  // Processors never see the wakeup
+  for (int n = 0; n < event_num; ) {
+    if (events[n].data.u64 == WakeupData) {
+      uint64_t value;
+      ssize_t got = ::read(wakeup_fd_, &value, sizeof(value));
+      (void)got;
+      events[n] = events[--event_num];
+    } else {
+      ++n;
+    }
+  }
+  if (event_num > 0)
+    event_buffer_.publish(begin_seq + event_num - 1);
 }
 
 } } // namespace ku::fusion
@@ -6,19 +6,46 @@
  ***************************************************************/ 
 #pragma once
 #include <sys/epoll.h>
+#include <cstdint>
 #include <chrono>
 #include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "event_buffer.hpp"
+#include "event_processor.hpp"
+#include "util.hpp"
 
 namespace ku { namespace fusion {
 
-class Poller
+// =======================================================================================
+// Poller runs epoll_wait straight into an EventBuffer, EventProcessor threads handle the
+// events, so I/O readiness is polled on one thread and handled on the others.
+//   poller.start(4, handler);
+//   std::thread loop(std::ref(poller));
+//   ...
+//   poller.quit_loop();
+//   loop.join();
+//   poller.join();
+// =======================================================================================
+class Poller : private util::noncopyable
 {
 public:
+  using Handler = EventProcessor::Handler;
+  // epoll_event::data of the eventfd waking up epoll_wait, reserved
+  static uint64_t const WakeupData = ~uint64_t(0);
+
   Poller(int flags, size_t buf_size);
+  ~Poller();
+
+  EventBuffer& event_buffer() { return event_buffer_; }
+
+  // Starts count processors to handle events, before loop
+  void start(size_t count, Handler const& handler);
+  // Wakes up the loop, processors exit once events published so far are handled
+  void quit_loop();
+  void join();
 
-  // TODO quit should be able to wake up poll loop (probably with an eventfd)
-  void quit_loop() { quit_.store(true, std::memory_order_release); }
   void loop(std::chrono::milliseconds const& timeout);
   void operator()(std::chrono::milliseconds const& timeout = std::chrono::milliseconds(-1));
 
@@ -31,8 +58,10 @@ private:
 
 private:
   EventBuffer event_buffer_;
-  unsigned active_count_;
+  std::vector<std::unique_ptr<EventProcessor>> processors_;
+  std::vector<std::thread> threads_;
   int raw_handle_;
+  int wakeup_fd_;
   std::atomic_bool quit_;
 };
 
@@ -5,34 +5,62 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #include <cassert>
-#include <limits>
-#include <algorithm>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include "processor_barrier.hpp"
 #include "sequence.hpp"
+#include "util.hpp"
 
 namespace ku { namespace fusion {
 
-size_t ProcessorBarrier::max_sequence() const
+size_t ProcessorBarrier::wait_for(Sequence const& published, size_t seq)
 {
-  assert(!processor_seqs_.empty());
-  size_t max = 0;
-  for (auto const seq_ptr : processor_seqs_) {
-    size_t const value = seq_ptr->get();
-    max = std::max(max, value);
+  size_t available;
+  if ((available = published.get()) >= seq)
+    return available;
+
+  auto const spin_end = std::chrono::steady_clock::now() + spin_time_;
+  for (unsigned count = 1; (available = published.get()) < seq && !alerted(); ++count) {
+    // Reads the clock once every 64 spins
+    if (count % 64 != 0 || std::chrono::steady_clock::now() < spin_end)
+      util::cpu_relax();
+    else
+      available = block(published, seq);
   }
-  return max;
+  return available;
+}
+
+void ProcessorBarrier::alert()
+{
+  alerted_.store(true, std::memory_order_release);
+  wake();
 }
 
-size_t ProcessorBarrier::min_sequence() const
+size_t ProcessorBarrier::block(Sequence const& published, size_t seq)
 {
-  assert(!processor_seqs_.empty());
-  size_t min = std::numeric_limits<size_t>::max();
-  for (auto const seq_ptr : processor_seqs_) {
-    size_t const value = seq_ptr->get();
-    min = std::min(min, value);
+  // Reading epoch before registering, a wake in between changes it and futex returns
+  uint32_t const epoch = epoch_.load(std::memory_order_acquire);
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  size_t available = published.get();
+  if (available < seq && !alerted()) {
+    auto const start = WaitStats::Clock::now();
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch,
+              nullptr, nullptr, 0);
+    stats_.record_wait(1, WaitStats::Clock::now() - start);
+    available = published.get();
   }
-  return min;
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return available;
 }
 
+void ProcessorBarrier::wake()
+{
+  epoch_.fetch_add(1, std::memory_order_release);
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+}
 
 } } // namespace ku::fusion
@@ -6,29 +6,72 @@
  ***************************************************************/ 
 #pragma once
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
 #include <vector>
+#include "sequence.hpp"
+#include "telemetry.hpp"
 
 namespace ku { namespace fusion {
 
-class Sequence;
-
+// Gates the publisher on processors, and blocks processors till events are published.
+// Processors spin for the spin time first, for the latency of busy spinning under load,
+// then sleep on a futex, mostly idle ones cost no cpu.
 class ProcessorBarrier
 {
 public:
-  ProcessorBarrier() = default;
+  ProcessorBarrier()
+    : spin_time_(std::chrono::microseconds(50)), epoch_(0), waiters_(0), alerted_(false)
+  { }
   ~ProcessorBarrier() = default;
 
-  size_t max_sequence() const;
-  size_t min_sequence() const;
+  size_t max_sequence() const { return processor_seqs_.max_sequence(); }
+  size_t min_sequence() const { return processor_seqs_.min_sequence(); }
+  bool empty() const { return processor_seqs_.empty(); }
+  // Current values, in the order added
+  std::vector<size_t> sequences() const { return processor_seqs_.sequences(); }
 
   template <typename Processor>
   void add_processor(Processor const& pr)
   {
-    processor_seqs_.push_back(&(pr.sequence()));
+    processor_seqs_.add(&(pr.sequence()));
+  }
+
+  // Zero blocks right away
+  void set_spin_time(std::chrono::nanoseconds spin_time) { spin_time_ = spin_time; }
+
+  // For processors, spins then blocks until seq is published, returns the published
+  // sequence. It is lower than seq once alerted.
+  size_t wait_for(Sequence const& published, size_t seq);
+  // For the publisher, a syscall only if any processor is blocked
+  void notify_all()
+  {
+    // Pairs with the fence in block(), either the waiter sees the published or we see it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) > 0)
+      wake();
   }
 
+  // Processors stop blocking, for them to exit
+  void alert();
+  void clear_alert() { alerted_.store(false, std::memory_order_release); }
+  bool alerted() const { return alerted_.load(std::memory_order_acquire); }
+
+  // Sleeps of processors on the futex, and time they blocked
+  WaitStats const& stats() const { return stats_; }
+
+private:
+  size_t block(Sequence const& published, size_t seq);
+  void wake();
+
 private:
-  std::vector<Sequence const*> processor_seqs_; 
+  SequenceList processor_seqs_;
+  std::chrono::nanoseconds spin_time_;
+  std::atomic<uint32_t> epoch_;
+  std::atomic<int> waiters_;
+  std::atomic_bool alerted_;
+  WaitStats stats_;
 };
 
 } } // namespace ku::fusion
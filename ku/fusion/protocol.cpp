@@ -10,7 +10,7 @@
 
 namespace {
 static char const* protocols[] = {
-  "invalid", "inproc", "ipc", "tcp", "pgm", "ws"
+  "invalid", "inproc", "ipc", "tcp", "pgm", "ws", "shm"
 };
 } // unamed namespace
 
@@ -18,13 +18,13 @@ namespace ku { namespace fusion {
 
 std::string to_str(Protocol p)
 {
-  assert(p >= Protocol::Invalid && p <= Protocol::WS);
+  assert(p >= Protocol::Invalid && p <= Protocol::Shm);
   return protocols[static_cast<int>(p)];
 }
 
 Protocol str_to_protocol(std::string const& s)
 {
-  for (unsigned i = 0; i < sizeof(protocols); ++i)
+  for (unsigned i = 0; i < sizeof(protocols) / sizeof(protocols[0]); ++i)
     if (s.compare(protocols[i]) == 0)
       return static_cast<Protocol>(i);
   return Protocol::Invalid;
@@ -11,7 +11,7 @@ namespace ku { namespace fusion {
 
 enum class Protocol
 {
-  Invalid = 0, Inproc, IPC, TCP, PGM, WS 
+  Invalid = 0, Inproc, IPC, TCP, PGM, WS, Shm
 };
 
 inline bool operator!(Protocol p) { return static_cast<int>(p) > 0; }
@@ -4,6 +4,7 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include "sequence.hpp"
@@ -12,21 +13,92 @@ namespace ku { namespace fusion {
 
 size_t SequenceList::min_sequence() const
 {
-  assert(!list_.empty());
+  assert(!empty());
+  return min_sequence(0);
+}
+
+size_t SequenceList::min_sequence(size_t default_value) const
+{
+  Snapshot const* list = list_.load(std::memory_order_acquire);
+  if (!list || list->empty())
+    return default_value;
   size_t min = std::numeric_limits<size_t>::max();
-  for (auto const seq_ptr : list_) {
+  for (auto const seq_ptr : *list) {
     size_t const value = seq_ptr->get();
     min = min < value ? min : value;
   }
   return min;
 }
 
-void SequenceList::initialize(std::initializer_list<Sequence*> const& seqs)
+size_t SequenceList::max_sequence() const
+{
+  assert(!empty());
+  size_t max = 0;
+  for (auto const seq_ptr : *list_.load(std::memory_order_acquire)) {
+    size_t const value = seq_ptr->get();
+    max = max > value ? max : value;
+  }
+  return max;
+}
+
+bool SequenceList::empty() const
+{
+  Snapshot const* list = list_.load(std::memory_order_acquire);
+  return !list || list->empty();
+}
+
+std::vector<size_t> SequenceList::sequences() const
+{
+  std::vector<size_t> values;
+  if (Snapshot const* list = list_.load(std::memory_order_acquire)) {
+    for (auto const seq_ptr : *list)
+      values.push_back(seq_ptr->get());
+  }
+  return values;
+}
+
+void SequenceList::initialize(std::initializer_list<Sequence const*> const& seqs)
 {
-  assert(list_.empty());
+  assert(empty());
   assert(seqs.size() > 0);
-  for (auto seq_ptr : seqs)
-    list_.push_back(seq_ptr);
+  update([&](Snapshot& list) { list.assign(seqs.begin(), seqs.end()); });
+}
+
+void SequenceList::initialize(std::vector<Sequence*> const& seqs)
+{
+  assert(empty());
+  assert(seqs.size() > 0);
+  update([&](Snapshot& list) { list.assign(seqs.begin(), seqs.end()); });
+}
+
+void SequenceList::add(Sequence const* seq)
+{
+  update([=](Snapshot& list) { list.push_back(seq); });
+}
+
+bool SequenceList::remove(Sequence const* seq)
+{
+  bool found = false;
+  update([&](Snapshot& list) {
+    auto it = std::find(list.begin(), list.end(), seq);
+    if ((found = it != list.end()))
+      list.erase(it);
+  });
+  return found;
+}
+
+template <typename F>
+void SequenceList::update(F f)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Snapshot const* old_list = list_.load(std::memory_order_relaxed);
+  std::unique_ptr<Snapshot> new_list(old_list ? new Snapshot(*old_list) : new Snapshot());
+  f(*new_list);
+  if (old_list)
+    retired_.reserve(retired_.size() + 1); // no throw after swapping
+  list_.store(new_list.release(), std::memory_order_release);
+  if (old_list)
+    retired_.emplace_back(old_list);
 }
 
 } } // namespace ku::fusion
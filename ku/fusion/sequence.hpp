@@ -6,43 +6,90 @@
  ***************************************************************/ 
 #pragma once
 #include <cstddef>
-#include <type_traits>
 #include <initializer_list>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
+#include "util.hpp"
 
 namespace ku { namespace fusion {
 
+// =======================================================================================
+// Sequence of EventBuffer and the disruptor rings, padded to two cache lines, the adjacent
+// line prefetcher pulls 128 bytes at a time on x86, a sequence sharing either line with a
+// hot neighbour false shares.
+// The orders are explicit, each sequence has one writer:
+//   get()          acquire, for other threads reading what the writer published
+//   get_relaxed()  for the writer, reading back its own value
+//   set()          release, a lazy set, visible once the store buffer drains
+//   set_fenced()   sequentially consistent, for a writer checking for sleepers right after
+// =======================================================================================
 class Sequence
 {
 public:
   Sequence(size_t value) { set(value); }
   ~Sequence() = default;
 
-  // These get/set work in the assumption that there is only one writer
+  static void* operator new(size_t size) { return util::cache_aligned_new(size); }
+  static void operator delete(void* p) { util::cache_aligned_delete(p); }
+
   size_t get() const { return value_.load(std::memory_order_acquire); }
+  size_t get_relaxed() const { return value_.load(std::memory_order_relaxed); }
   void set(size_t value) { value_.store(value, std::memory_order_release); }
+  void set_fenced(size_t value) { value_.store(value, std::memory_order_seq_cst); }
   bool cas(size_t old_value, size_t new_value) { return value_.compare_exchange_strong(old_value, new_value); }
+  // For multiple writers, returns the value before adding
+  size_t fetch_add(size_t incr) { return value_.fetch_add(incr, std::memory_order_acq_rel); }
 
 private:
-  union {
-    std::aligned_storage<64, 64>::type _; // align to/ocuppy 64 bytes for cache line
-    std::atomic_size_t value_;
-  };
+  alignas(util::CacheAlign) std::atomic_size_t value_;
+  char padding_[util::CacheAlign - sizeof(std::atomic_size_t)];
 };
 
-static_assert(std::alignment_of<Sequence>::value == 64, "Sequence not aligned with cache line, may cause false sharing.");
-static_assert(sizeof(Sequence) == 64, "Sequence not padded to cache line, may cause false sharing.");
+static_assert(std::alignment_of<Sequence>::value == util::CacheAlign, "Sequence not aligned with cache line pair, may cause false sharing.");
+static_assert(sizeof(Sequence) == util::CacheAlign, "Sequence not padded to cache line pair, may cause false sharing.");
 
 
+// =======================================================================================
+// SequenceList is read by publishers and consumers on every wait, and changed rarely, by
+// consumers joining or leaving a live ring. Readers load an immutable snapshot with no
+// lock, writers copy it, change the copy and swap it in. Snapshots swapped out are kept
+// until destruction, as a reader may still be iterating one, they cost a few pointers
+// per change.
+// =======================================================================================
 class SequenceList
 {
+  using Snapshot = std::vector<Sequence const*>;
+
 public:
+  SequenceList() : list_(nullptr) { }
+  ~SequenceList() { delete list_.load(std::memory_order_relaxed); }
+
+  SequenceList(SequenceList const&) = delete;
+  SequenceList& operator=(SequenceList const&) = delete;
+
   size_t min_sequence() const;
-  void initialize(std::initializer_list<Sequence*> const& seqs);
+  // Returns default_value if empty
+  size_t min_sequence(size_t default_value) const;
+  size_t max_sequence() const;
+  bool empty() const;
+  // Current values, in the order added
+  std::vector<size_t> sequences() const;
+  void initialize(std::initializer_list<Sequence const*> const& seqs);
+  void initialize(std::vector<Sequence*> const& seqs);
+
+  void add(Sequence const* seq);
+  bool remove(Sequence const* seq); // false if not found
+
+private:
+  template <typename F>
+  void update(F f);
 
 private:
-  std::vector<Sequence*> list_;
+  std::atomic<Snapshot const*> list_;
+  std::vector<std::unique_ptr<Snapshot const>> retired_;
+  std::mutex mutex_; // for writers only
 };
 
 } } // namespace ku::fusion
@@ -56,16 +56,23 @@ Socket AcceptorSocket::accept(SocketEndpoint& endpoint)
   return Socket(ops::Socket::accept(handle_, endpoint));
 }
 
-void AcceptorSocket::bind_listen(SocketEndpoint const& endpoint)
+void AcceptorSocket::bind_listen(SocketEndpoint const& endpoint, bool reuse_port)
 {
   handle_.close();
   handle_ = ops::Socket::create(acceptor_addrinfo(endpoint));
   if (endpoint.address_family() == SocketEndpoint::Unix)
     ::unlink(endpoint.address().c_str()); // The error can be generally ignored
+  else if (reuse_port)
+    ops::Socket::reuse_port(handle_);
   ops::Socket::bind(handle_, endpoint);
   ops::Socket::listen(handle_);
 }
 
+SocketEndpoint AcceptorSocket::local_endpoint() const
+{
+  return ops::Socket::local_endpoint(handle_);
+}
+
 /// ConnectorSocket ///
 //
 void ConnectorSocket::connect(SocketEndpoint const& endpoint, bool non_block)
@@ -54,7 +54,10 @@ public:
   HandleType const& handle() const { return handle_; }
   Socket accept(SocketEndpoint& endpoint);
 
-  void bind_listen(SocketEndpoint const& endpoint);
+  // With reuse_port, acceptors bound to the same endpoint share its connections
+  void bind_listen(SocketEndpoint const& endpoint, bool reuse_port = false);
+  // The bound endpoint, with the port picked if bound to port 0
+  SocketEndpoint local_endpoint() const;
 
 private:
   HandleType handle_;
@@ -27,10 +27,13 @@ template <typename Connection>
 class SocketAcceptor
 {
 public:
-  SocketAcceptor(SocketEndpoint const& local_endpoint, NoticeBoard& notices)
-    : local_endpoint_(local_endpoint), notices_(notices)
+  SocketAcceptor(SocketEndpoint const& local_endpoint, NoticeBoard& notices,
+                 bool reuse_port = false)
+    : notices_(notices)
   {
-    socket_.bind_listen(local_endpoint);
+    socket_.bind_listen(local_endpoint, reuse_port);
+    local_endpoint_ = local_endpoint.address_family() == SocketEndpoint::Unix
+                    ? local_endpoint : socket_.local_endpoint();
     notices_.add_notice(socket_.handle(), { Notice::Inbound }, 
         [this](Notice::Event, NoticeId) { return (*this)(); });
   }
@@ -38,7 +41,7 @@ public:
   bool operator ()()
   {
     accept_connections(socket_, notices_, 
-        [](Socket&& socket, SocketEndpoint const& peer_endpoint) -> HandlerCreator {
+        [](Socket&& socket, SocketEndpoint const& peer_endpoint) -> Notice::EventHandler {
           // TODO exception safe
           Connection* conn_ptr = new Connection(std::move(socket), peer_endpoint);
           return Notice::EventHandler([conn_ptr](Notice::Event event, NoticeId id) {
@@ -49,7 +52,8 @@ public:
   }
 
   AcceptorSocket& socket() { return socket_; }
-  SocketEndpoint const& local_endpoint() { return local_endpoint; }
+  // With the port picked if bound to port 0
+  SocketEndpoint const& local_endpoint() const { return local_endpoint_; }
 
 private:
   SocketEndpoint local_endpoint_;
@@ -5,29 +5,139 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <utility>
-#include "../epoll_poller.hpp" 
+#include <vector>
+#include "../epoll_poller.hpp"
 #include "../socket_acceptor.hpp"
+#include "../server_connection.hpp"
 
 namespace ku { namespace fusion { namespace tcp {
 
+// =======================================================================================
+// tcp::Server runs one reactor, a poll loop with its acceptor, per thread. With more than
+// one, each listens on its own SO_REUSEPORT socket bound to the endpoint, the kernel
+// spreads connections over them, and a connection is served by the loop that accepted
+// it all along, its handler never shared among threads.
+// =======================================================================================
 template <typename EventHandler>
-class Server
+class Server : private util::noncopyable
 {
   using Connection = ServerConnection<EventHandler>;
 
+  struct Reactor
+  {
+    Reactor(SocketEndpoint const& local_endpoint, bool reuse_port)
+      : acceptor(local_endpoint, loop.notices(), reuse_port) { }
+
+    epoll::PollLoop loop;
+    SocketAcceptor<Connection> acceptor;
+  };
+
 public:
-  Server(SocketEndpoint const& local_endpoint)
-    : acceptor_(local_endpoint, loop_.notices()) { }
+  // Loops wake up this often to see stop()
+  static constexpr std::chrono::milliseconds PollTimeout() { return std::chrono::milliseconds(100); }
+
+  // One loop, run by the caller of operator()
+  explicit Server(SocketEndpoint const& local_endpoint) : Server(local_endpoint, 1, false) { }
+  // loops loops, the first run by the caller of operator(). If pinned, loop n runs on the
+  // n-th cpu, round robin, of those the constructing thread may run on. The caller's
+  // thread is unpinned once operator() returns.
+  Server(SocketEndpoint const& local_endpoint, size_t loops, bool pinned = false);
+
+  // Runs till stop(). Stops all loops and rethrows if one of them fails.
+  bool operator()();
+
+  void stop();
 
-  bool operator()() { return loop_(); }
+  size_t loops() const { return reactors_.size(); }
+  // With the port picked if bound to port 0
+  SocketEndpoint const& local_endpoint() const { return reactors_.front()->acceptor.local_endpoint(); }
 
-  void stop() { loop_.quit(); }
+private:
+  bool run(size_t n);
 
 private:
-  epoll::PollLoop loop_;
-  SocketAcceptor<Connection> acceptor_;
+  std::vector<std::unique_ptr<Reactor>> reactors_;
+  std::vector<int> cpus_; // empty unless pinned
 };
 
+template <typename EventHandler>
+Server<EventHandler>::Server(SocketEndpoint const& local_endpoint, size_t loops, bool pinned)
+{
+  assert(loops > 0);
+  if (pinned)
+    cpus_ = util::cpu_affinity();
+  bool const reuse_port = loops > 1;
+  reactors_.emplace_back(new Reactor(local_endpoint, reuse_port));
+  // The others bind to the port the first got, if it asked for port 0
+  for (size_t n = 1; n < loops; ++n)
+    reactors_.emplace_back(new Reactor(reactors_.front()->acceptor.local_endpoint(), reuse_port));
+}
+
+template <typename EventHandler>
+bool Server<EventHandler>::operator()()
+{
+  // However run(0) ends, stops and joins the other loops and unpins the caller
+  struct Guard
+  {
+    ~Guard()
+    {
+      server.stop();
+      for (std::thread& t : threads)
+        t.join();
+      if (!caller_cpus.empty()) {
+        try { util::set_cpu_affinity(caller_cpus); }
+        catch (std::system_error const&) { }
+      }
+    }
+
+    Server& server;
+    std::vector<std::thread> threads;
+    std::vector<int> caller_cpus;
+  };
+
+  std::vector<std::exception_ptr> errors(reactors_.size());
+  bool ret;
+  {
+    Guard guard{*this, {}, cpus_.empty() ? std::vector<int>() : util::cpu_affinity()};
+    for (size_t n = 1; n < reactors_.size(); ++n) {
+      guard.threads.emplace_back([this, n, &errors]() {
+        try {
+          run(n);
+        } catch (...) {
+          errors[n] = std::current_exception();
+          stop();
+        }
+      });
+    }
+    ret = run(0);
+  }
+  for (std::exception_ptr const& error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+  return ret;
+}
+
+template <typename EventHandler>
+void Server<EventHandler>::stop()
+{
+  for (auto& reactor : reactors_)
+    reactor->loop.quit();
+}
+
+template <typename EventHandler>
+bool Server<EventHandler>::run(size_t n)
+{
+  if (!cpus_.empty())
+    util::set_cpu_affinity(cpus_[n % cpus_.size()]);
+  return reactors_[n]->loop(PollTimeout());
+}
+
 } } } // namespace ku::fusion::tcp
 
@@ -0,0 +1,58 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include "telemetry.hpp"
+
+namespace ku { namespace fusion {
+
+namespace {
+
+size_t bucket_of(size_t rounds)
+{
+  size_t bucket = 0;
+  while (rounds >>= 1)
+    ++bucket;
+  return bucket < WaitSnapshot::Buckets ? bucket : WaitSnapshot::Buckets - 1;
+}
+
+} // unamed namespace
+
+WaitStats::WaitStats() : waited_ns_(0), max_occupancy_(0)
+{
+  for (auto& count : histogram_)
+    count.store(0, std::memory_order_relaxed);
+}
+
+void WaitStats::record_wait(size_t rounds, Clock::duration waited)
+{
+  histogram_[bucket_of(rounds)].fetch_add(1, std::memory_order_relaxed);
+  waited_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(),
+                       std::memory_order_relaxed);
+}
+
+void WaitStats::record_occupancy(size_t occupancy)
+{
+  size_t max = max_occupancy_.load(std::memory_order_relaxed);
+  while (occupancy > max &&
+         !max_occupancy_.compare_exchange_weak(max, occupancy, std::memory_order_relaxed))
+    ;
+}
+
+WaitSnapshot WaitStats::snapshot() const
+{
+  WaitSnapshot snapshot;
+  snapshot.waits = 0;
+  for (size_t n = 0; n < WaitSnapshot::Buckets; ++n) {
+    snapshot.histogram[n] = histogram_[n].load(std::memory_order_relaxed);
+    snapshot.waits += snapshot.histogram[n];
+  }
+  snapshot.waited = std::chrono::nanoseconds(waited_ns_.load(std::memory_order_relaxed));
+  snapshot.max_occupancy = max_occupancy_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+} } // namespace ku::fusion
+
@@ -0,0 +1,71 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "util.hpp"
+
+namespace ku { namespace fusion {
+
+// Waits of a side of a ring, as sampled by WaitStats::snapshot()
+struct WaitSnapshot
+{
+  static size_t const Buckets = 16;
+
+  // Waits by log2 of how long they took, in idle rounds or sleeps: [1], [2, 3], [4, 7],
+  // ..., the last bucket takes all above
+  uint64_t histogram[Buckets];
+  uint64_t waits;
+  std::chrono::nanoseconds waited;
+  size_t max_occupancy;
+};
+
+// =======================================================================================
+// WaitStats counts waits on a ring, only on the slow path where the waiter would idle
+// anyway. It sits on cache lines of its own, aligned as Sequence to a prefetched pair,
+// monitoring threads read it without touching those of the publisher or consumers.
+// =======================================================================================
+class alignas(util::CacheAlign) WaitStats : private util::noncopyable
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  WaitStats();
+
+  // rounds > 0 idle rounds, or sleeps, that took waited
+  void record_wait(size_t rounds, Clock::duration waited);
+  // Claimed, up to capacity, but not yet processed by the slowest consumer, seen
+  // refreshing the gating
+  void record_occupancy(size_t occupancy);
+
+  WaitSnapshot snapshot() const;
+
+private:
+  std::atomic<uint64_t> histogram_[WaitSnapshot::Buckets];
+  std::atomic<uint64_t> waited_ns_;
+  std::atomic<size_t> max_occupancy_;
+};
+
+// A sample of a ring, for monitoring threads
+struct RingTelemetry
+{
+  size_t capacity;
+  // Published but not yet processed by the slowest consumer
+  size_t occupancy;
+  // Cursor minus sequence, of each consumer
+  std::vector<size_t> lags;
+  // Waits of the publisher for consumers to free slots, max_occupancy included
+  WaitSnapshot publisher;
+  // Time consumers blocked for events, EventBuffer only
+  WaitSnapshot consumers;
+};
+
+} } // namespace ku::fusion
+
@@ -1,5 +1,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
 #include "util.hpp"
 
 namespace ku { namespace fusion { namespace util {
@@ -15,4 +18,41 @@ size_t next_pow_of_two(size_t val)
   return ++val;
 }
 
+void* cache_aligned_new(size_t size)
+{
+  void* p = nullptr;
+  if (::posix_memalign(&p, CacheAlign, size))
+    throw std::bad_alloc();
+  return p;
+}
+
+std::vector<int> cpu_affinity()
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (::sched_getaffinity(0, sizeof(cpu_set), &cpu_set))
+    throw std::system_error(errc(), "util::cpu_affinity");
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &cpu_set))
+      cpus.push_back(cpu);
+  return cpus;
+}
+
+void set_cpu_affinity(int cpu)
+{
+  set_cpu_affinity(std::vector<int>(1, cpu));
+}
+
+void set_cpu_affinity(std::vector<int> const& cpus)
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus)
+    CPU_SET(cpu, &cpu_set);
+  int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (err)
+    throw std::system_error(err, std::system_category(), "util::set_cpu_affinity");
+}
+
 } } } // namespace ku::fusion::util
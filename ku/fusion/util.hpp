@@ -1,12 +1,42 @@
 #pragma once
 #include <errno.h>
+#include <cstddef>
+#include <cstdlib>
 #include <system_error>
+#include <vector>
 
 namespace ku { namespace fusion { namespace util {
 
 size_t next_pow_of_two(size_t val);
 inline size_t ceiling_pow_of_two(size_t val) { return next_pow_of_two(val - 1); }
 
+// Alignment of Sequence, two cache lines as the adjacent line prefetcher pulls pairs
+size_t const CacheAlign = 128;
+
+// For class operator new of types holding Sequence, new doesn't honour alignment beyond
+// max_align_t before C++17
+void* cache_aligned_new(size_t size);
+inline void cache_aligned_delete(void* p) { ::free(p); }
+
+// The cpus the calling thread may run on, by sched_getaffinity, the cpuset of a
+// container or taskset included
+std::vector<int> cpu_affinity();
+// Pins the calling thread to cpu, or to cpus
+void set_cpu_affinity(int cpu);
+void set_cpu_affinity(std::vector<int> const& cpus);
+
+// Hints the cpu of a spin-wait loop, saves power and the pipeline flush on loop exit
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+
 inline std::error_code errc(int err)
 {
   return std::make_error_code(static_cast<std::errc>(err));
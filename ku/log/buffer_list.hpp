@@ -54,6 +54,8 @@ public:
   }
 
   void combine(BufferList&& list);
+  // Forget all nodes without freeing them, their space must have been handed elsewhere
+  void disown() { size_ = 0; }
 
   uint32_t capacity() const { return capacity_; }
   uint32_t size() const { return size_; }
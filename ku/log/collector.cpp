@@ -9,11 +9,13 @@
 
 namespace ku { namespace log {
 
-Collector::Collector(LogLevel log_level, BufferList& free_queue, Logger& logger)
-  : logger_(logger), message_(log_level, free_queue)
+Collector::Collector(LogLevel log_level, BufferList& free_queue, uint32_t node, Logger& logger)
+  : logger_(logger), message_(log_level, free_queue, node)
 {
   char buf[32];
-  size_t sz = util::now(buf);
+  uint64_t time;
+  size_t sz = util::now(buf, time);
+  message_.set_time(time);
   message_.append(buf, sz);
   char const* s_log_level = to_log(message_.log_level());
   message_.append(s_log_level, std::strlen(s_log_level)); 
@@ -25,7 +25,7 @@ class Collector : private util::noncopyable
 {
 public:
   Collector() = delete;
-  Collector(LogLevel log_level, BufferList& free_queue, Logger& logger);
+  Collector(LogLevel log_level, BufferList& free_queue, uint32_t node, Logger& logger);
   Collector(Collector&& col) : logger_(col.logger_), message_(std::move(col.message_)) { }
 
   ~Collector();
@@ -0,0 +1,54 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cstring>
+#include <sys/uio.h>
+#include "compress_sink.hpp"
+#include "lz.hpp"
+
+namespace ku { namespace log {
+
+CompressSink::CompressSink(Sink_ptr sink)
+  : Sink(sink->log_level(), sink->format()), sink_(std::move(sink)), frame_list_(1),
+    raw_size_(0), compressed_size_(0)
+{
+}
+
+void CompressSink::write(BufferList const& list, WriteInfo const& info)
+{
+  // lz matches within contiguous input only, gather the nodes first
+  iovec const* p = list.raw_buffer();
+  size_t size = 0;
+  for (uint32_t n = 0; n < list.raw_buffer_count(); ++n)
+    size += p[n].iov_len;
+  if (!size)
+    return;
+  if (input_.size() < size)
+    input_.resize(size);
+  char* q = input_.data();
+  for (uint32_t n = 0; n < list.raw_buffer_count(); ++n) {
+    std::memcpy(q, p[n].iov_base, p[n].iov_len);
+    q += p[n].iov_len;
+  }
+
+  if (frame_.size() < lz::frame_bound(size))
+    frame_.resize(lz::frame_bound(size));
+  Buffer::Node node = { frame_.data(), lz::encode_frame(input_.data(), size, frame_.data()) };
+  raw_size_ += size;
+  compressed_size_ += node.used;
+
+  // frame_ stays owned here, the list only lends it to the wrapped sink
+  frame_list_.push_back(&node, 1);
+  try {
+    sink_->write(frame_list_, info);
+  } catch (...) {
+    frame_list_.disown();
+    throw;
+  }
+  frame_list_.disown();
+}
+
+} } // namespace ku::log
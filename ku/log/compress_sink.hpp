@@ -0,0 +1,45 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <vector>
+#include "sink.hpp"
+#include "buffer_list.hpp"
+
+namespace ku { namespace log {
+
+// =======================================================================================
+// CompressSink compresses each write to one lz frame (see lz.hpp) before handing it to
+// the sink it wraps, e.g.
+//   logger.add_sink(Sink_ptr(new CompressSink(Sink_ptr(new FileSink(...)))));
+// Compression runs on the writer thread, so collecting threads don't pay for it. Write
+// info is passed through, so the index of a FileSink points to frame boundaries, from
+// which log_extract decompresses.
+// Level and format are taken from the wrapped sink.
+// =======================================================================================
+class CompressSink : public Sink
+{
+public:
+  explicit CompressSink(Sink_ptr sink);
+
+  using Sink::write;
+  virtual void write(BufferList const& list) { write(list, WriteInfo()); }
+  virtual void write(BufferList const& list, WriteInfo const& info);
+
+  Sink& sink() { return *sink_; }
+
+  // Bytes before and after compression, for checking the ratio
+  uint64_t raw_size() const { return raw_size_; }
+  uint64_t compressed_size() const { return compressed_size_; }
+
+private:
+  Sink_ptr sink_;
+  std::vector<char> input_, frame_;
+  BufferList frame_list_;
+  uint64_t raw_size_, compressed_size_;
+};
+
+} } // namespace ku::log
@@ -5,6 +5,7 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
@@ -0,0 +1,100 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include "buffer.hpp"
+
+namespace ku { namespace log {
+
+// =======================================================================================
+// Structured fields are appended to the message buffer in binary, no text conversion
+// is done by the producer. Sinks render them on the writer thread (see render.hpp).
+//
+// A field is encoded as:
+//   FieldMarker, FieldType, key size (1 byte), key, value
+// where value is the native representation of bool (1 byte), int64_t, uint64_t or double,
+// or a 4-byte size followed by the bytes for strings.
+// FieldMarker (ASCII record separator) is reserved in messages with fields.
+// =======================================================================================
+char const FieldMarker = '\x1e';
+
+enum class FieldType : uint8_t
+{
+  Bool, Int, Uint, Double, String
+};
+
+size_t const MaxFieldKeySize = 255;
+
+namespace detail {
+
+inline void append_field(Buffer& buf, char const* key, FieldType type,
+                         void const* value, size_t value_size)
+{
+  char head[3 + MaxFieldKeySize + sizeof(uint64_t)];
+  size_t key_size = std::min(std::strlen(key), MaxFieldKeySize);
+  head[0] = FieldMarker;
+  head[1] = static_cast<char>(type);
+  head[2] = static_cast<char>(key_size);
+  std::memcpy(head + 3, key, key_size);
+  std::memcpy(head + 3 + key_size, value, value_size);
+  buf.append(head, 3 + key_size + value_size);
+}
+
+inline void append_string_field(Buffer& buf, char const* key, char const* s, size_t size)
+{
+  uint32_t value_size = static_cast<uint32_t>(size);
+  append_field(buf, key, FieldType::String, &value_size, sizeof(value_size));
+  buf.append(s, size);
+}
+
+} // namespace detail
+
+inline void append_field(Buffer& buf, char const* key, bool value)
+{
+  uint8_t v = value;
+  detail::append_field(buf, key, FieldType::Bool, &v, sizeof(v));
+}
+
+template <typename T>
+auto append_field(Buffer& buf, char const* key, T value)
+  -> typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+{
+  int64_t v = value;
+  detail::append_field(buf, key, FieldType::Int, &v, sizeof(v));
+}
+
+template <typename T>
+auto append_field(Buffer& buf, char const* key, T value)
+  -> typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+{
+  uint64_t v = value;
+  detail::append_field(buf, key, FieldType::Uint, &v, sizeof(v));
+}
+
+template <typename T>
+auto append_field(Buffer& buf, char const* key, T value)
+  -> typename std::enable_if<std::is_floating_point<T>::value>::type
+{
+  double v = value;
+  detail::append_field(buf, key, FieldType::Double, &v, sizeof(v));
+}
+
+inline void append_field(Buffer& buf, char const* key, char const* value)
+{
+  detail::append_string_field(buf, key, value, std::strlen(value));
+}
+
+inline void append_field(Buffer& buf, char const* key, std::string const& value)
+{
+  detail::append_string_field(buf, key, value.data(), value.size());
+}
+
+} } // namespace ku::log
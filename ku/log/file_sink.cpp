@@ -21,13 +21,30 @@ namespace ku { namespace log {
 FileSink::FileSink(char const* path, char const* base_name, LogLevel log_level)
   : Sink(log_level), seq_no_(0), path_(path), base_name_(base_name)
   , size_(0), size_limit_(512 << 20) // 512 MB
+  , index_interval_(IndexWriter::DefaultInterval)
 {
   open();
 }
 
-void FileSink::write(BufferList const& list)
+void FileSink::set_index_interval(size_t interval)
 {
-  size_ += ::writev(file_handle_, list.raw_buffer(), list.raw_buffer_count());
+  index_interval_ = interval;
+  index_.set_interval(interval);
+  // What is written after is the unindexed tail
+  if (!interval)
+    index_.close();
+  // Turned on, the index is opened with the next log file, one opened now would have no
+  // entries for what is written so far, and lookups would skip it
+}
+
+void FileSink::write(BufferList const& list, WriteInfo const& info)
+{
+  ssize_t written = ::writev(file_handle_, list.raw_buffer(), list.raw_buffer_count());
+  if (written <= 0)
+    return;
+  if (index_interval_)
+    index_.add(size_, written, info);
+  size_ += written;
   if (size_ >= size_limit_) {
     close();
     rotate();
@@ -55,14 +72,18 @@ std::string FileSink::file_name(int seq_no) const
 
 void FileSink::open()
 {
-  file_handle_ = ::open(file_name().c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0777);
+  std::string name = file_name();
+  file_handle_ = ::open(name.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0777);
   assert(file_handle_ > 0);
   if (file_handle_ < 0)
     file_handle_ = 0;
+  if (file_handle_ && index_interval_)
+    index_.open(index_file_name(name));
 }
 
 void FileSink::close()
 {
+  index_.close();
   if (file_handle_) {
     ::fsync(file_handle_);
     ::close(file_handle_);
@@ -71,7 +92,9 @@ void FileSink::close()
 
 void FileSink::rotate()
 {
-  rename(file_name().c_str(), file_name(++seq_no_).c_str());
+  std::string name = file_name(), rotated_name = file_name(++seq_no_);
+  rename(name.c_str(), rotated_name.c_str());
+  rename(index_file_name(name).c_str(), index_file_name(rotated_name).c_str());
 }
 
 } } // namespace ku::log
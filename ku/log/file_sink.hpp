@@ -6,18 +6,28 @@
  ***************************************************************/ 
 #pragma once
 #include "sink.hpp"
+#include "log_index.hpp"
 
 namespace ku { namespace log {
 
+// =======================================================================================
+// FileSink writes to path/base_name_YYYYMMDD_pid.log, rotating at size limit.
+// Along with the log, it writes a time index (see log_index.hpp) every index interval
+// bytes, an interval of 0 turns the index off. Turning it on takes effect from the next
+// log file.
+// =======================================================================================
 class FileSink : public Sink
 {
 public:
   FileSink(char const* path, char const* base_name, LogLevel log_level = LogLevel::Debug);
   virtual ~FileSink() { close(); }
 
-  virtual void write(BufferList const& list);
+  using Sink::write;
+  virtual void write(BufferList const& list) { write(list, WriteInfo()); }
+  virtual void write(BufferList const& list, WriteInfo const& info);
 
   void set_size_limit(size_t limit) { size_limit_ = limit; }
+  void set_index_interval(size_t interval);
 
 private:
   std::string file_name(int seq_no = 0) const;
@@ -30,6 +40,8 @@ private:
   int seq_no_;
   std::string path_, base_name_;
   size_t size_, size_limit_;
+  size_t index_interval_;
+  IndexWriter index_;
 };
 
 } } // namespace ku::log
@@ -6,21 +6,30 @@
  ***************************************************************/ 
 #pragma once
 #include "logger.hpp"
+#include "registry.hpp"
 #include "collector.hpp"
 
-#define LOG(level) \
-  if (LogLevel::level < g_logger().log_level()); \
-  else g_logger().create_collector(LogLevel::level).message()
+// LOG_TO family logs to the given logger handle (a Logger&), which is evaluated twice,
+// so pass a resolved reference rather than a registry lookup
+#define LOG_TO(logger, level) \
+  if (LogLevel::level < (logger).log_level()); \
+  else (logger).create_collector(LogLevel::level).message()
 
-#define LOG_IF(level, cond) \
-  if (LogLevel::level < g_logger().log_level() || !(cond)); \
-  else g_logger().create_collector(LogLevel::level).message()
+#define LOG_TO_IF(logger, level, cond) \
+  if (LogLevel::level < (logger).log_level() || !(cond)); \
+  else (logger).create_collector(LogLevel::level).message()
+
+#define LOG(level) LOG_TO(g_logger(), level)
+
+#define LOG_IF(level, cond) LOG_TO_IF(g_logger(), level, cond)
 
 // DLOG family would be eliminated completely with NDEBUG flag defined
 #ifndef NDEBUG
 
 #define DLOG(level) LOG(level)
 #define DLOG_IF(level, cond) LOG_IF(level, cond)
+#define DLOG_TO(logger, level) LOG_TO(logger, level)
+#define DLOG_TO_IF(logger, level, cond) LOG_TO_IF(logger, level, cond)
 
 #else // NDEBUG
 
@@ -30,5 +39,10 @@
 #define DLOG_IF(level, cond) \
   if (true); else LOG(level)
 
-#endif // NDEBUG
+#define DLOG_TO(logger, level) \
+  if (true); else LOG_TO(logger, level)
 
+#define DLOG_TO_IF(logger, level, cond) \
+  if (true); else LOG_TO(logger, level)
+
+#endif // NDEBUG
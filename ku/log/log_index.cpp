@@ -0,0 +1,153 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <system_error>
+#include "log_index.hpp"
+
+namespace {
+
+char const IndexMagic[8] = { 'K', 'U', 'L', 'O', 'G', 'I', 'D', 'X' };
+uint32_t const IndexVersion = 1;
+
+std::system_error make_error(char const* what)
+{
+  return std::system_error(errno, std::system_category(), what);
+}
+
+// Maps the whole file read-only, an empty file maps to nullptr
+void const* map_file(std::string const& name, size_t& size)
+{
+  int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    throw make_error("IndexReader::map_file");
+  struct stat st;
+  if (::fstat(fd, &st) == -1) {
+    ::close(fd);
+    throw make_error("IndexReader::map_file");
+  }
+  size = st.st_size;
+  void* p = nullptr;
+  if (size && (p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    ::close(fd);
+    throw make_error("IndexReader::map_file");
+  }
+  ::close(fd);
+  return p;
+}
+
+} // unamed namespace
+
+namespace ku { namespace log {
+
+std::string index_file_name(std::string const& log_file_name)
+{
+  return log_file_name + ".idx";
+}
+
+/// IndexWriter ///
+//
+void IndexWriter::open(std::string const& index_file)
+{
+  close();
+  file_handle_ = ::open(index_file.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (file_handle_ == -1)
+    return; // index is an aid, losing it doesn't stop logging
+  IndexHeader header;
+  std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+  header.version = IndexVersion;
+  header.entry_size = sizeof(IndexEntry);
+  ::write(file_handle_, &header, sizeof(header));
+  block_.size = 0;
+}
+
+void IndexWriter::close()
+{
+  if (file_handle_ != -1) {
+    write_block();
+    ::close(file_handle_);
+    file_handle_ = -1;
+  }
+}
+
+void IndexWriter::add(uint64_t offset, size_t size, WriteInfo const& info)
+{
+  if (file_handle_ == -1 || !size)
+    return;
+  if (!block_.size) {
+    block_.begin_time = info.begin_time;
+    block_.end_time = info.end_time;
+    block_.offset = offset;
+    block_.level_mask = 0;
+  }
+  block_.begin_time = std::min(block_.begin_time, info.begin_time);
+  block_.end_time = std::max(block_.end_time, info.end_time);
+  block_.size += size;
+  block_.level_mask |= info.level_mask;
+  if (block_.size >= interval_)
+    write_block();
+}
+
+void IndexWriter::write_block()
+{
+  if (block_.size) {
+    ::write(file_handle_, &block_, sizeof(block_));
+    block_.size = 0;
+  }
+}
+
+/// IndexReader ///
+//
+IndexReader::IndexReader(std::string const& log_file)
+  : data_(nullptr), size_(0), index_data_(nullptr), index_size_(0)
+  , entries_(nullptr), entry_count_(0)
+{
+  data_ = static_cast<char const*>(map_file(log_file, size_));
+  try {
+    index_data_ = map_file(index_file_name(log_file), index_size_);
+  } catch (...) {
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+    throw;
+  }
+  IndexHeader const* header = static_cast<IndexHeader const*>(index_data_);
+  if (index_size_ >= sizeof(IndexHeader)
+      && std::memcmp(header->magic, IndexMagic, sizeof(IndexMagic)) == 0
+      && header->version == IndexVersion && header->entry_size == sizeof(IndexEntry)) {
+    entries_ = reinterpret_cast<IndexEntry const*>(header + 1);
+    entry_count_ = (index_size_ - sizeof(IndexHeader)) / sizeof(IndexEntry);
+  }
+  // Otherwise there are no entries, the whole log is the unindexed tail
+}
+
+IndexReader::~IndexReader()
+{
+  if (data_) ::munmap(const_cast<char*>(data_), size_);
+  if (index_data_) ::munmap(const_cast<void*>(index_data_), index_size_);
+}
+
+uint64_t IndexReader::indexed_size() const
+{
+  if (!entry_count_)
+    return 0;
+  IndexEntry const& last = entries_[entry_count_ - 1];
+  return std::min<uint64_t>(last.offset + last.size, size_);
+}
+
+IndexEntry const* IndexReader::lower_bound(uint64_t time) const
+{
+  // First block that may end at or after time
+  return std::lower_bound(begin(), end(), time,
+      [](IndexEntry const& entry, uint64_t t) { return entry.end_time < t; });
+}
+
+} } // namespace ku::log
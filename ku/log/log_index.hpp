@@ -0,0 +1,125 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+#include "util.hpp"
+#include "sink.hpp"
+
+namespace ku { namespace log {
+
+// =======================================================================================
+// Log index is a sidecar file (log file name + ".idx") of fixed size entries, one entry
+// per block of roughly interval bytes of the log file. Each entry tells the time span,
+// the file range and the log levels of the messages in the block, so a time window can
+// be found by binary search, and blocks without interesting levels can be skipped.
+//
+// Entries are in file order, time spans are in collecting order, which is close to but
+// not strictly the order messages are written in.
+// =======================================================================================
+struct IndexHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;
+};
+
+struct IndexEntry
+{
+  uint64_t begin_time, end_time; // nanoseconds since epoch
+  uint64_t offset;
+  uint32_t size;
+  uint32_t level_mask;
+};
+
+static_assert(sizeof(IndexHeader) == 16, "IndexHeader is part of file format");
+static_assert(sizeof(IndexEntry) == 32, "IndexEntry is part of file format");
+
+std::string index_file_name(std::string const& log_file_name);
+
+class IndexWriter : private util::noncopyable
+{
+public:
+  static const size_t DefaultInterval = 64 << 10; // 64 KB
+
+  IndexWriter() : file_handle_(-1), interval_(DefaultInterval) { block_.size = 0; }
+  ~IndexWriter() { close(); }
+
+  // Truncates the index file and writes the header
+  void open(std::string const& index_file);
+  // Writes the pending block
+  void close();
+
+  size_t interval() const { return interval_; }
+  void set_interval(size_t interval) { interval_ = interval; }
+
+  // Records size bytes of messages written at offset of the log file
+  void add(uint64_t offset, size_t size, WriteInfo const& info);
+
+private:
+  void write_block();
+
+private:
+  int file_handle_;
+  size_t interval_;
+  IndexEntry block_;
+};
+
+// =======================================================================================
+// IndexReader maps a log file and its index for reading.
+// Throws std::system_error if either file can't be mapped.
+// =======================================================================================
+class IndexReader : private util::noncopyable
+{
+public:
+  explicit IndexReader(std::string const& log_file);
+  ~IndexReader();
+
+  char const* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  IndexEntry const* begin() const { return entries_; }
+  IndexEntry const* end() const { return entries_ + entry_count_; }
+  // Log data after the last entry isn't indexed (yet)
+  uint64_t indexed_size() const;
+
+  // Calls f(char const* data, size_t size) for every log range that may hold messages
+  // collected in [begin_time, end_time] with any level in level_mask, the unindexed
+  // tail of the log is always included
+  template <typename F>
+  void for_each_block(uint64_t begin_time, uint64_t end_time, uint32_t level_mask, F f) const;
+
+private:
+  IndexEntry const* lower_bound(uint64_t time) const;
+
+private:
+  char const* data_;
+  size_t size_;
+  void const* index_data_;
+  size_t index_size_;
+  IndexEntry const* entries_;
+  size_t entry_count_;
+};
+
+template <typename F>
+void IndexReader::for_each_block(uint64_t begin_time, uint64_t end_time, uint32_t level_mask,
+                                 F f) const
+{
+  for (IndexEntry const* entry = lower_bound(begin_time); entry != end(); ++entry) {
+    if (entry->begin_time > end_time)
+      break;
+    if ((entry->level_mask & level_mask) && entry->offset < size_)
+      f(data_ + entry->offset, std::min<size_t>(entry->size, size_ - entry->offset));
+  }
+  uint64_t tail = indexed_size();
+  if (tail < size_)
+    f(data_ + tail, size_ - tail);
+}
+
+} } // namespace ku::log
@@ -4,6 +4,7 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <cstring>
 #include "log_level.hpp"
 
 namespace ku { namespace log {
@@ -26,5 +27,21 @@ char const* to_log(LogLevel level)
   }
 }
 
+bool to_log_level(char const* str, size_t size, LogLevel& level)
+{
+  while (size && *str == ' ')
+    ++str, --size;
+  while (size && str[size - 1] == ' ')
+    --size;
+  for (uint32_t n = 0; n <= static_cast<uint32_t>(LogLevel::Fatal); ++n) {
+    char const* name = to_log(static_cast<LogLevel>(n)) + 1; // skip the leading space
+    if (std::strncmp(name, str, size) == 0 && (name[size] == ' ' || name[size] == '\0')) {
+      level = static_cast<LogLevel>(n);
+      return true;
+    }
+  }
+  return false;
+}
+
 } } // namespace ku::log
 
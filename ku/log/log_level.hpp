@@ -5,6 +5,7 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace ku { namespace log {
@@ -16,5 +17,8 @@ enum class LogLevel : uint32_t
 
 char const* to_log(LogLevel level);
 
+// Parses a level name as written by to_log(), surrounding spaces are ignored
+bool to_log_level(char const* str, size_t size, LogLevel& level);
+
 } } // namespace ku::log
 
@@ -4,18 +4,34 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
 #include <chrono>
+#include <system_error>
 #include "message.hpp"
 #include "logger.hpp"
 
 namespace ku { namespace log {
 
-Logger::Logger() : quit_(false), log_level_(LogLevel::Debug)
+Logger::Logger(std::string const& name)
+  : name_(name), thread_tid_(0), quit_(false), log_level_(LogLevel::Debug)
+  , flush_count_(MessageQueue::FlushCount)
+  , flush_interval_(std::chrono::milliseconds(std::chrono::seconds(3)).count())
 {
+  free_queues_.resize(util::numa_node_count());
+  for (auto& free_queue : free_queues_)
+    free_queue.reset(new FreeQueue);
   // Initial free buffer space pool, a typical flush size of MessageQueue is 4K.
   // FreeHeap doubles this to allow free space allocated during flushing operation.
+  // Only the pool of the current node is filled, pools of other nodes fill up with
+  // space malloc'ed (and first touched) by producers running there.
   const static size_t FreeHeap = 8192;
-  free_queue_.allocate_space(FreeHeap);
+  uint32_t node = util::numa_node();
+  free_queues_[node < free_queues_.size() ? node : 0]->list.allocate_space(FreeHeap);
   message_queue_.reserve();
   std::thread(&Logger::write, this).swap(thread_);
 }
@@ -33,19 +49,58 @@ void Logger::submit(Message&& message)
   {
     std::lock_guard<std::mutex> lock(message_queue_mutex_);
     message_queue_.emplace_back(std::move(message));
-    flushable = message_queue_.flushable();
+    flushable = message_queue_.flushable(flush_count());
   }
   if (flushable)
     write_condition_.notify_one();
 }
 
+void Logger::set_cpu_affinity(std::vector<int> const& cpus)
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus)
+    CPU_SET(cpu, &cpu_set);
+  int err = ::pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set), &cpu_set);
+  if (err)
+    throw std::system_error(err, std::system_category(), "Logger::set_cpu_affinity");
+}
+
+void Logger::set_scheduling(int policy, int priority)
+{
+  sched_param param;
+  param.sched_priority = priority;
+  int err = ::pthread_setschedparam(thread_.native_handle(), policy, &param);
+  if (err)
+    throw std::system_error(err, std::system_category(), "Logger::set_scheduling");
+}
+
+void Logger::set_nice(int nice)
+{
+  // On Linux nice value is per thread, addressed by the kernel thread id
+  if (::setpriority(PRIO_PROCESS, writer_tid(), nice) == -1)
+    throw std::system_error(errno, std::system_category(), "Logger::set_nice");
+}
+
+pid_t Logger::writer_tid() const
+{
+  // The writer thread publishes its tid as the first thing it does
+  pid_t tid;
+  while (!(tid = thread_tid_.load(std::memory_order_acquire)))
+    std::this_thread::yield();
+  return tid;
+}
+
 void Logger::write()
 {
+  thread_tid_.store(::syscall(SYS_gettid), std::memory_order_release);
+
+  std::vector<BufferList> node_lists(free_queues_.size());
   std::unique_lock<std::mutex> lock(message_queue_mutex_, std::defer_lock);
   while (true) {
     lock.lock();
     while (message_queue_.empty() && !quit_)
-      write_condition_.wait_for(lock, std::chrono::seconds(3));
+      write_condition_.wait_for(lock, flush_interval());
     if (message_queue_.empty()) {
       lock.unlock();
       if (quit_) break; else continue;
@@ -53,14 +108,25 @@ void Logger::write()
     MessageQueue queue(std::move(message_queue_));
     lock.unlock();
 
-    for (auto& sink_ptr : sink_list_)
-      queue.flush_to(*sink_ptr);
-    queue.buffers().reclaim_space();
     {
-      // Message flushed, return heap space back to free_queue_
-      std::lock_guard<std::mutex> lock(free_queue_mutex_);
-      free_queue_.combine(std::move(queue.buffers()));
-      // TODO might need a shrinking strategy
+      std::lock_guard<std::mutex> sink_lock(sink_list_mutex_);
+      for (auto& sink_ptr : sink_list_)
+        queue.flush_to(*sink_ptr);
+    }
+    queue.buffers().reclaim_space();
+    // Message flushed, return heap space back to the free queue of the node it came from
+    // TODO might need a shrinking strategy
+    if (free_queues_.size() == 1) {
+      std::lock_guard<std::mutex> lock(free_queues_[0]->mutex);
+      free_queues_[0]->list.combine(std::move(queue.buffers()));
+    } else {
+      queue.split_by_node(node_lists);
+      for (size_t node = 0; node < node_lists.size(); ++node) {
+        if (!node_lists[node].size())
+          continue;
+        std::lock_guard<std::mutex> lock(free_queues_[node]->mutex);
+        free_queues_[node]->list.combine(std::move(node_lists[node]));
+      }
     }
   }
 }
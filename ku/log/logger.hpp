@@ -5,7 +5,13 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <sys/types.h>
 #include <forward_list>
+#include <vector>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -19,39 +25,90 @@ namespace ku { namespace log {
 
 class Message;
 
-class Logger
+// =======================================================================================
+// Logger owns a writer thread, a sink list and a free buffer pool. Loggers are fully
+// independent of each other, so a burst on one never delays the writes of another.
+// g_logger() is the default instance, named ones are kept in the Registry.
+//
+// The free buffer pool is split per NUMA node. A producer takes buffer space from the
+// pool of the node it is running on, and flushed space goes back to the node it came
+// from, so log buffers stay local to the producers that touch them.
+// =======================================================================================
+class Logger : private util::noncopyable
 {
   using SinkList = std::forward_list<Sink_ptr>;
-  friend Logger& g_logger();
+
+  struct FreeQueue
+  {
+    std::mutex mutex;
+    BufferList list;
+  };
+  using FreeQueues = std::vector<std::unique_ptr<FreeQueue>>;
 
 public:
+  explicit Logger(std::string const& name = std::string());
   ~Logger();
-  void add_sink(Sink_ptr sink) { sink_list_.push_front(std::move(sink)); }
+
+  std::string const& name() const { return name_; }
+  // Safe while the writer thread runs, it waits for the flush in progress
+  void add_sink(Sink_ptr sink)
+  {
+    std::lock_guard<std::mutex> lock(sink_list_mutex_);
+    sink_list_.push_front(std::move(sink));
+  }
 
   Collector create_collector(LogLevel log_level)
   {
-    std::lock_guard<std::mutex> lock(free_queue_mutex_);
-    return Collector(log_level, free_queue_, *this);
+    uint32_t node = free_queues_.size() > 1 ? util::numa_node() : 0;
+    // Clamped once, the message carries the node its space is returned to
+    if (node >= free_queues_.size())
+      node = 0;
+    FreeQueue& free_queue = *free_queues_[node];
+    std::lock_guard<std::mutex> lock(free_queue.mutex);
+    return Collector(log_level, free_queue.list, node, *this);
   }
 
   void submit(Message&& message);
   LogLevel log_level() const { return log_level_; }
   void set_log_level(LogLevel log_level) { log_level_ = log_level; }
 
-private:
-  Logger();
+  // Flush policy: the writer thread is woken once flush_count buffer nodes are queued,
+  // and flushes whatever is queued at least every flush_interval. Both may change while
+  // it runs.
+  size_t flush_count() const { return flush_count_.load(std::memory_order_relaxed); }
+  void set_flush_count(size_t count) { flush_count_.store(count, std::memory_order_relaxed); }
+  std::chrono::milliseconds flush_interval() const
+  { return std::chrono::milliseconds(flush_interval_.load(std::memory_order_relaxed)); }
+  void set_flush_interval(std::chrono::milliseconds interval)
+  { flush_interval_.store(interval.count(), std::memory_order_relaxed); }
 
+  // Writer thread placement, all of them throw std::system_error on failure.
+  // Pin the writer thread to the given CPU set
+  void set_cpu_affinity(std::vector<int> const& cpus);
+  // Scheduling policy (SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR) and
+  // static priority, which must be 0 for non real-time policies
+  void set_scheduling(int policy, int priority = 0);
+  // Nice value of the writer thread, applies to non real-time policies
+  void set_nice(int nice);
+
+private:
   void write();
+  pid_t writer_tid() const;
 
 private:
+  std::string name_;
   std::thread thread_;
+  std::atomic<pid_t> thread_tid_;
   MessageQueue message_queue_;
-  BufferList free_queue_;
-  std::mutex message_queue_mutex_, free_queue_mutex_;
+  FreeQueues free_queues_;
+  std::mutex message_queue_mutex_;
   std::condition_variable write_condition_;
+  std::mutex sink_list_mutex_;
   SinkList sink_list_;
   bool quit_;
   LogLevel log_level_;
+  std::atomic<size_t> flush_count_;
+  std::atomic<std::chrono::milliseconds::rep> flush_interval_; // milliseconds
 };
 
 Logger& g_logger();
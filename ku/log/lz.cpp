@@ -0,0 +1,196 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cstring>
+#include "lz.hpp"
+
+namespace {
+
+size_t const MinMatch = 4;
+size_t const MaxOffset = 65535;
+size_t const LastLiterals = 5; // matches stop this far from the end, like LZ4
+unsigned const HashBits = 12;
+uint32_t const FrameMagic = 0x5a4c554b; // "KULZ" in little endian
+
+inline uint32_t read32(char const* p)
+{
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void write32(char* p, uint32_t v) { std::memcpy(p, &v, sizeof(v)); }
+
+inline uint32_t hash(uint32_t v) { return (v * 2654435761u) >> (32 - HashBits); }
+
+uint32_t checksum(char const* p, size_t size)
+{
+  uint32_t h = 2166136261u; // FNV-1a
+  for (char const* end = p + size; p < end; ++p)
+    h = (h ^ static_cast<uint8_t>(*p)) * 16777619u;
+  return h;
+}
+
+// Writes length beyond what the token holds in 255-continued bytes
+inline char* write_length(char* op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = static_cast<char>(255);
+  *op++ = static_cast<char>(len);
+  return op;
+}
+
+inline bool read_length(char const*& ip, char const* end, size_t& len)
+{
+  uint8_t b;
+  do {
+    if (ip >= end)
+      return false;
+    b = static_cast<uint8_t>(*ip++);
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+char* write_sequence(char* op, char const* literals, size_t lit_len, size_t offset, size_t match_len)
+{
+  char* token = op++;
+  *token = static_cast<char>((lit_len < 15 ? lit_len : 15) << 4);
+  if (lit_len >= 15)
+    op = write_length(op, lit_len - 15);
+  std::memcpy(op, literals, lit_len);
+  op += lit_len;
+  if (match_len) {
+    *op++ = static_cast<char>(offset & 0xff);
+    *op++ = static_cast<char>(offset >> 8);
+    size_t len = match_len - MinMatch;
+    *token |= static_cast<char>(len < 15 ? len : 15);
+    if (len >= 15)
+      op = write_length(op, len - 15);
+  }
+  return op;
+}
+
+} // unamed namespace
+
+namespace ku { namespace log { namespace lz {
+
+size_t compress(char const* src, size_t size, char* dst)
+{
+  uint32_t table[1 << HashBits] = { 0 }; // position + 1, 0 is empty
+  char* op = dst;
+  size_t anchor = 0, pos = 0;
+  if (size > MinMatch + LastLiterals) {
+    size_t const limit = size - LastLiterals - MinMatch;
+    while (pos <= limit) {
+      uint32_t const seq = read32(src + pos);
+      uint32_t& slot = table[hash(seq)];
+      size_t const ref = slot;
+      slot = pos + 1;
+      if (ref && pos - (ref - 1) <= MaxOffset && read32(src + ref - 1) == seq) {
+        size_t const match = ref - 1;
+        size_t len = MinMatch;
+        while (pos + len < size - LastLiterals && src[match + len] == src[pos + len])
+          ++len;
+        op = write_sequence(op, src + anchor, pos - anchor, pos - match, len);
+        pos += len;
+        anchor = pos;
+      } else {
+        // Skip faster through data that doesn't compress
+        pos += 1 + ((pos - anchor) >> 6);
+      }
+    }
+  }
+  return write_sequence(op, src + anchor, size - anchor, 0, 0) - dst;
+}
+
+bool decompress(char const* src, size_t size, char* dst, size_t dst_size)
+{
+  char const* ip = src;
+  char const* const end = src + size;
+  char* op = dst;
+  char* const op_end = dst + dst_size;
+  while (ip < end) {
+    uint8_t const token = static_cast<uint8_t>(*ip++);
+    size_t lit_len = token >> 4;
+    if (lit_len == 15 && !read_length(ip, end, lit_len))
+      return false;
+    if (size_t(end - ip) < lit_len || size_t(op_end - op) < lit_len)
+      return false;
+    std::memcpy(op, ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+    if (ip == end)
+      break; // last sequence has literals only
+    if (end - ip < 2)
+      return false;
+    size_t const offset = static_cast<uint8_t>(ip[0]) | static_cast<uint8_t>(ip[1]) << 8;
+    ip += 2;
+    size_t match_len = token & 0x0f;
+    if (match_len == 15 && !read_length(ip, end, match_len))
+      return false;
+    match_len += MinMatch;
+    if (!offset || size_t(op - dst) < offset || size_t(op_end - op) < match_len)
+      return false;
+    // Byte by byte, match may overlap what it is copying
+    for (char const* match = op - offset; match_len; --match_len)
+      *op++ = *match++;
+  }
+  return op == op_end;
+}
+
+size_t encode_frame(char const* src, size_t size, char* dst)
+{
+  char* payload = dst + FrameHeaderSize;
+  size_t stored = compress(src, size, payload);
+  if (stored >= size) {
+    std::memcpy(payload, src, size);
+    stored = size;
+  }
+  write32(dst, FrameMagic);
+  write32(dst + 4, size);
+  write32(dst + 8, stored);
+  write32(dst + 12, checksum(payload, stored));
+  return FrameHeaderSize + stored;
+}
+
+size_t decode_frame(char const* src, size_t size, std::string& out)
+{
+  if (size < FrameHeaderSize || read32(src) != FrameMagic)
+    return 0;
+  size_t const raw = read32(src + 4), stored = read32(src + 8);
+  char const* payload = src + FrameHeaderSize;
+  if (stored > raw || size - FrameHeaderSize < stored || checksum(payload, stored) != read32(src + 12))
+    return 0;
+  size_t const out_size = out.size();
+  if (stored == raw) {
+    out.append(payload, stored);
+  } else {
+    out.resize(out_size + raw);
+    if (!decompress(payload, stored, &out[out_size], raw)) {
+      out.resize(out_size);
+      return 0;
+    }
+  }
+  return FrameHeaderSize + stored;
+}
+
+char const* find_frame(char const* src, size_t size)
+{
+  char const* const end = src + size;
+  for (char const* p = src; size_t(end - p) >= FrameHeaderSize; ++p) {
+    if (read32(p) != FrameMagic)
+      continue;
+    // Checks the checksum only, a magic inside compressed data won't match it
+    size_t const raw = read32(p + 4), stored = read32(p + 8);
+    if (stored <= raw && size_t(end - p) - FrameHeaderSize >= stored
+        && checksum(p + FrameHeaderSize, stored) == read32(p + 12))
+      return p;
+  }
+  return end;
+}
+
+} } } // namespace ku::log::lz
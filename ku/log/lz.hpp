@@ -0,0 +1,44 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ku { namespace log { namespace lz {
+
+// =======================================================================================
+// lz is a small, fast LZ77 codec using the LZ4 block layout (4-byte min match, 64 KB
+// window, greedy hash matching), it trades ratio for speed, which is what log volume
+// needs.
+//
+// Frames make compressed streams self-delimiting. Each frame is compressed on its own,
+// so decoding can start from any frame boundary:
+//   magic "KULZ", raw size, stored size, FNV-1a checksum of the stored bytes, then
+//   the stored bytes, which are kept uncompressed if compressing doesn't make them smaller
+// All header fields are 4 bytes little endian.
+// =======================================================================================
+size_t const FrameHeaderSize = 16;
+
+// Max compressed size of size bytes
+inline size_t compress_bound(size_t size) { return size + size / 255 + 16; }
+inline size_t frame_bound(size_t size) { return FrameHeaderSize + compress_bound(size); }
+
+// Compresses src to dst, which has at least compress_bound(size) bytes, returns the size
+size_t compress(char const* src, size_t size, char* dst);
+// Decompresses to dst of exactly dst_size bytes, returns false on corrupted input
+bool decompress(char const* src, size_t size, char* dst, size_t dst_size);
+
+// Writes a frame of src to dst, which has at least frame_bound(size) bytes, returns the size
+size_t encode_frame(char const* src, size_t size, char* dst);
+// Appends the content of the frame at src to out, returns the frame size, or 0 if there
+// isn't a complete, valid frame at src
+size_t decode_frame(char const* src, size_t size, std::string& out);
+// Returns the first position in [src, src + size) that starts a valid frame, or src + size
+char const* find_frame(char const* src, size_t size);
+
+} } } // namespace ku::log::lz
@@ -7,6 +7,7 @@
 #pragma once
 #include "log_level.hpp"
 #include "buffer.hpp"
+#include "field.hpp"
 
 namespace ku { namespace log {
 
@@ -14,10 +15,12 @@ class Message : private util::noncopyable
 {
 public:
   Message() = delete;
-  Message(LogLevel log_level, BufferList& free_queue)
-    : log_level_(log_level), buffer_(free_queue) { }
+  // node is the NUMA node of free_queue, flushed buffer space is returned to it
+  Message(LogLevel log_level, BufferList& free_queue, uint32_t node = 0)
+    : log_level_(log_level), node_(node), time_(0), field_count_(0), buffer_(free_queue) { }
   Message(Message&& message)
-    : log_level_(message.log_level_), buffer_(std::move(message.buffer_)) { }
+    : log_level_(message.log_level_), node_(message.node_), time_(message.time_)
+    , field_count_(message.field_count_), buffer_(std::move(message.buffer_)) { }
 
   iovec const* raw_buffer() const { return buffer_.raw_buffer(); }
   size_t raw_buffer_count() const { return buffer_.raw_buffer_count(); }
@@ -31,10 +34,29 @@ public:
   template <typename... Args>
   Message& operator () (char const* fmt, Args... args);
 
+  // Structured field collecting, e.g.
+  //   LOG(Info).kv("order_id", id).kv("px", px) << "order accepted";
+  // Fields are kept binary and rendered by sinks, see field.hpp
+  template <typename T>
+  Message& kv(char const* key, T const& value)
+  {
+    append_field(buffer_, key, value);
+    ++field_count_;
+    return *this;
+  }
+  uint32_t field_count() const { return field_count_; }
+
   LogLevel log_level() { return log_level_; }
+  uint32_t node() const { return node_; }
+  // Collecting time in nanoseconds since epoch
+  uint64_t time() const { return time_; }
+  void set_time(uint64_t time) { time_ = time; }
 
 private:
   LogLevel log_level_;
+  uint32_t node_;
+  uint64_t time_;
+  uint32_t field_count_;
   Buffer buffer_;
 };
 
@@ -4,30 +4,83 @@
  *                                                             *
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
+#include <cassert>
+#include <string>
 #include "sink.hpp"
+#include "render.hpp"
 #include "message_queue.hpp"
 
 namespace ku { namespace log {
 
 void MessageQueue::flush_to(Sink& sink)
 {
+  // Text without structured fields is written as collected, anything else is rendered
+  if (sink.format() != Format::Text || field_message_count_)
+    return render_to(sink);
+
   // If the whole buffers_'s log_level is no less than this sink, write the buffer directly,
   // otherwise, copy out those nodes that log_level is no less than the sink, then write the copy.
+  WriteInfo write_info;
   if (min_log_level_ >= sink.log_level()) {
-    sink.write(buffers_);
+    for (MessageInfo const& info : index_)
+      write_info.add(info.log_level, info.time);
+    sink.write(buffers_, write_info);
   } else {
     BufferList bufs;
     bufs.reserve(buffers_.raw_buffer_count());
     Buffer::Node const* node_ptr = reinterpret_cast<Buffer::Node const*>(buffers_.raw_buffer());
     for (MessageInfo const& info : index_) {
-      if (info.log_level >= sink.log_level())
+      if (info.log_level >= sink.log_level()) {
         bufs.push_back(node_ptr, info.raw_buffer_count);
+        write_info.add(info.log_level, info.time);
+      }
       node_ptr += info.raw_buffer_count;
     }
     // This one-shot write assumes sink uses blocking write,
     // or non-blocking but handle partial write internally
-    sink.write(bufs);
+    sink.write(bufs, write_info);
+    // bufs only borrows the nodes of buffers_, don't let it free them
+    bufs.disown();
+  }
+}
+
+void MessageQueue::render_to(Sink& sink)
+{
+  WriteInfo write_info;
+  Buffer rendered;
+  std::string message;
+  Buffer::Node const* node_ptr = reinterpret_cast<Buffer::Node const*>(buffers_.raw_buffer());
+  for (MessageInfo const& info : index_) {
+    if (info.log_level >= sink.log_level()) {
+      message.clear();
+      for (uint32_t n = 0; n < info.raw_buffer_count; ++n)
+        message.append(node_ptr[n].data, node_ptr[n].used);
+      render(sink.format(), message.data(), message.size(), info.field_count, rendered);
+      write_info.add(info.log_level, info.time);
+    }
+    node_ptr += info.raw_buffer_count;
+  }
+  if (rendered.empty())
+    return;
+  BufferList bufs;
+  bufs.push_back(reinterpret_cast<Buffer::Node const*>(rendered.raw_buffer()),
+                 rendered.raw_buffer_count());
+  sink.write(bufs, write_info);
+  // rendered owns the nodes
+  bufs.disown();
+}
+
+void MessageQueue::split_by_node(std::vector<BufferList>& lists)
+{
+  Buffer::Node const* node_ptr = reinterpret_cast<Buffer::Node const*>(buffers_.raw_buffer());
+  for (MessageInfo const& info : index_) {
+    assert(info.node < lists.size());
+    lists[info.node].push_back(node_ptr, info.raw_buffer_count);
+    node_ptr += info.raw_buffer_count;
   }
+  assert(node_ptr == reinterpret_cast<Buffer::Node const*>(buffers_.raw_buffer())
+                     + buffers_.raw_buffer_count());
+  buffers_.disown();
 }
 
 } } // namespace ku::log
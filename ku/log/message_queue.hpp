@@ -18,41 +18,58 @@ class MessageQueue
 {
   struct MessageInfo
   {
-    MessageInfo(LogLevel level, uint32_t count) : log_level(level), raw_buffer_count(count) { }
+    MessageInfo(LogLevel level, uint32_t count, uint32_t node, uint32_t fields, uint64_t time)
+      : log_level(level), raw_buffer_count(count), node(node), field_count(fields), time(time) { }
     LogLevel log_level;
     uint32_t raw_buffer_count;
+    uint32_t node;
+    uint32_t field_count;
+    uint64_t time;
   };
 
   using BufferIndex = std::vector<MessageInfo>;
-  const static size_t FlushCount = 16;
 
 public:
-  MessageQueue() : min_log_level_(LogLevel::Fatal) { }
+  const static size_t FlushCount = 16; // default flush count, see Logger::set_flush_count
+
+  MessageQueue() : min_log_level_(LogLevel::Fatal), field_message_count_(0) { }
   // move constructor is NOT thread safe, lock it when use
   MessageQueue(MessageQueue&& queue)
     : index_(std::move(queue.index_)) , buffers_(std::move(queue.buffers_))
-    , min_log_level_(LogLevel::Fatal)
-  { }
+    , min_log_level_(queue.min_log_level_), field_message_count_(queue.field_message_count_)
+  {
+    queue.min_log_level_ = LogLevel::Fatal;
+    queue.field_message_count_ = 0;
+  }
 
   void emplace_back(Message&& message)
   {
-    index_.emplace_back(message.log_level(), message.raw_buffer_count());
+    index_.emplace_back(message.log_level(), message.raw_buffer_count(), message.node(),
+                        message.field_count(), message.time());
     buffers_.emplace_back(std::move(message.buffer()));
     min_log_level_ = std::min(min_log_level_, message.log_level());
+    field_message_count_ += message.field_count() != 0;
   }
 
   void reserve() { index_.reserve(FlushCount); buffers_.reserve(FlushCount + FlushCount / 2); }
   inline bool empty() { return index_.empty(); }
 
-  bool flushable() const { return buffers_.raw_buffer_count() >= FlushCount; }
+  bool flushable(size_t flush_count) const { return buffers_.raw_buffer_count() >= flush_count; }
   void flush_to(Sink& sink);
 
   BufferList& buffers() { return buffers_; }
+  // Move buffer space to lists[node], node being where the message was collected
+  void split_by_node(std::vector<BufferList>& lists);
+
+private:
+  // Writes a copy rendered in the format of the sink
+  void render_to(Sink& sink);
 
 private:
   BufferIndex index_;
   BufferList buffers_;
   LogLevel min_log_level_;
+  uint32_t field_message_count_;
 };
 
 } } // namespace ku::log
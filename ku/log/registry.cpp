@@ -0,0 +1,48 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include "registry.hpp"
+
+namespace ku { namespace log {
+
+Logger& Registry::get(std::string const& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Logger>& logger_ptr = loggers_[name];
+  if (!logger_ptr)
+    logger_ptr.reset(new Logger(name));
+  return *logger_ptr;
+}
+
+Logger* Registry::find(std::string const& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto find = loggers_.find(name);
+  return loggers_.end() == find ? nullptr : find->second.get();
+}
+
+bool Registry::remove(std::string const& name)
+{
+  std::unique_ptr<Logger> logger_ptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto find = loggers_.find(name);
+    if (loggers_.end() == find)
+      return false;
+    logger_ptr = std::move(find->second);
+    loggers_.erase(find);
+  }
+  // Logger destructor joins the writer thread, do it out of the lock
+  return true;
+}
+
+Registry& g_registry()
+{
+  static Registry registry;
+  return registry;
+}
+
+} } // namespace ku::log
@@ -0,0 +1,49 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "util.hpp"
+#include "logger.hpp"
+
+namespace ku { namespace log {
+
+// =======================================================================================
+// Registry keeps named Logger instances, e.g. "audit", "journal", "diag".
+// Each logger has its own writer thread, sinks and flush policy.
+//
+// Lookup takes a lock, so resolve the logger once and keep the reference:
+//   Logger& journal = g_logger("journal");
+//   LOG_TO(journal, Info) << "order accepted";
+// =======================================================================================
+class Registry : private util::noncopyable
+{
+  using LoggerMap = std::map<std::string, std::unique_ptr<Logger>>;
+
+public:
+  Registry() = default;
+  ~Registry() = default;
+
+  // Returns the logger with the name, creates it on first use
+  Logger& get(std::string const& name);
+  // Returns nullptr if no logger has the name
+  Logger* find(std::string const& name);
+  // Flushes and destroys the logger, no one should be holding a reference to it
+  bool remove(std::string const& name);
+
+private:
+  std::mutex mutex_;
+  LoggerMap loggers_;
+};
+
+Registry& g_registry();
+
+inline Logger& g_logger(std::string const& name) { return g_registry().get(name); }
+
+} } // namespace ku::log
@@ -0,0 +1,239 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "field.hpp"
+#include "render.hpp"
+
+namespace {
+
+using namespace ku::log;
+
+size_t const TimeSize = 29; // "YYYY-MM-DD HH:MM:SS.nnnnnnnnn"
+size_t const LevelSize = 7; // to_log() output
+
+struct Field
+{
+  FieldType type;
+  char const* key;
+  size_t key_size;
+  char const* value;
+  size_t value_size;
+};
+
+// Decodes a field at p, returns the encoded size, 0 if it isn't a valid field
+size_t decode_field(char const* p, char const* end, Field& field)
+{
+  if (end - p < 3 || p[0] != FieldMarker
+      || static_cast<uint8_t>(p[1]) > static_cast<uint8_t>(FieldType::String))
+    return 0;
+  field.type = static_cast<FieldType>(p[1]);
+  field.key_size = static_cast<uint8_t>(p[2]);
+  field.key = p + 3;
+  char const* value = field.key + field.key_size;
+  size_t head_size = 0;
+  switch (field.type) {
+  case FieldType::Bool:
+    field.value_size = 1;
+    break;
+  case FieldType::String: {
+    uint32_t size;
+    if (end - value < static_cast<ptrdiff_t>(sizeof(size)))
+      return 0;
+    std::memcpy(&size, value, sizeof(size));
+    head_size = sizeof(size);
+    field.value_size = size;
+    break;
+  }
+  default:
+    field.value_size = sizeof(uint64_t);
+  }
+  field.value = value + head_size;
+  if (field.value > end || static_cast<size_t>(end - field.value) < field.value_size)
+    return 0;
+  return field.value + field.value_size - p;
+}
+
+// Splits body into text and fields
+void parse_body(char const* p, char const* end, uint32_t field_count,
+                std::string& text, std::vector<Field>& fields)
+{
+  while (p < end) {
+    char const* marker = field_count > fields.size()
+        ? static_cast<char const*>(std::memchr(p, FieldMarker, end - p)) : nullptr;
+    if (!marker) {
+      text.append(p, end);
+      return;
+    }
+    text.append(p, marker);
+    Field field;
+    if (size_t size = decode_field(marker, end, field)) {
+      fields.push_back(field);
+      p = marker + size;
+    } else {
+      text.push_back(*marker);
+      p = marker + 1;
+    }
+  }
+}
+
+void append(Buffer& out, char const* s) { out.append(s, std::strlen(s)); }
+
+void append_double(Buffer& out, double v, bool json)
+{
+  if (!std::isfinite(v))
+    return append(out, json ? "null" : std::isnan(v) ? "NaN" : v > 0 ? "+Inf" : "-Inf");
+  char buf[32];
+  // Shortest of the precisions that reads back the same value
+  int len = std::snprintf(buf, sizeof(buf), "%.15g", v);
+  if (std::strtod(buf, nullptr) != v)
+    len = std::snprintf(buf, sizeof(buf), "%.17g", v);
+  out.append(buf, len);
+}
+
+void append_json_string(Buffer& out, char const* s, size_t size)
+{
+  out.append('"');
+  for (char const* end = s + size; s < end; ++s) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      out.append('\\');
+      out.append(c);
+    } else if (c == '\n') {
+      out.append("\\n", 2);
+    } else if (c == '\t') {
+      out.append("\\t", 2);
+    } else if (c < 0x20) {
+      char buf[8];
+      out.append(buf, std::snprintf(buf, sizeof(buf), "\\u%04x", c));
+    } else {
+      out.append(c);
+    }
+  }
+  out.append('"');
+}
+
+void append_logfmt_string(Buffer& out, char const* s, size_t size)
+{
+  bool quote = !size;
+  for (size_t n = 0; n < size && !quote; ++n)
+    quote = s[n] <= ' ' || s[n] == '=' || s[n] == '"';
+  if (!quote)
+    return out.append(s, size);
+  out.append('"');
+  for (char const* end = s + size; s < end; ++s) {
+    if (*s == '"' || *s == '\\')
+      out.append('\\');
+    if (*s == '\n')
+      out.append("\\n", 2);
+    else
+      out.append(*s);
+  }
+  out.append('"');
+}
+
+void append_value(Buffer& out, Field const& field, bool json)
+{
+  char buf[32];
+  switch (field.type) {
+  case FieldType::Bool:
+    return append(out, *field.value ? "true" : "false");
+  case FieldType::Int: {
+    int64_t v;
+    std::memcpy(&v, field.value, sizeof(v));
+    return out.append(buf, std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v)));
+  }
+  case FieldType::Uint: {
+    uint64_t v;
+    std::memcpy(&v, field.value, sizeof(v));
+    return out.append(buf, std::snprintf(buf, sizeof(buf), "%llu",
+                                         static_cast<unsigned long long>(v)));
+  }
+  case FieldType::Double: {
+    double v;
+    std::memcpy(&v, field.value, sizeof(v));
+    return append_double(out, v, json);
+  }
+  case FieldType::String:
+    return json ? append_json_string(out, field.value, field.value_size)
+                : append_logfmt_string(out, field.value, field.value_size);
+  }
+}
+
+} // unamed namespace
+
+namespace ku { namespace log {
+
+void render(Format format, char const* message, size_t size, uint32_t field_count, Buffer& out)
+{
+  if (format == Format::Text && !field_count)
+    return out.append(message, size);
+
+  char const* end = message + size;
+  if (end > message && end[-1] == '\n')
+    --end;
+  size_t header_size = std::min<size_t>(end - message, TimeSize + LevelSize);
+  std::string text;
+  std::vector<Field> fields;
+  parse_body(message + header_size, end, field_count, text, fields);
+
+  // Level is padded with spaces by to_log()
+  char const* level = message + std::min(header_size, TimeSize);
+  char const* level_end = message + header_size;
+  while (level < level_end && *level == ' ') ++level;
+  while (level_end > level && level_end[-1] == ' ') --level_end;
+  size_t time_size = std::min(header_size, TimeSize);
+
+  switch (format) {
+  case Format::Text:
+    out.append(message, header_size);
+    out.append(text.data(), text.size());
+    for (Field const& field : fields) {
+      out.append(' ');
+      out.append(field.key, field.key_size);
+      out.append('=');
+      append_value(out, field, false);
+    }
+    break;
+  case Format::Logfmt:
+    append(out, "ts=");
+    append_logfmt_string(out, message, time_size);
+    append(out, " level=");
+    out.append(level, level_end - level);
+    append(out, " msg=");
+    append_logfmt_string(out, text.data(), text.size());
+    for (Field const& field : fields) {
+      out.append(' ');
+      out.append(field.key, field.key_size);
+      out.append('=');
+      append_value(out, field, false);
+    }
+    break;
+  case Format::Json:
+    append(out, "{\"ts\":");
+    append_json_string(out, message, time_size);
+    append(out, ",\"level\":");
+    append_json_string(out, level, level_end - level);
+    append(out, ",\"msg\":");
+    append_json_string(out, text.data(), text.size());
+    for (Field const& field : fields) {
+      out.append(',');
+      append_json_string(out, field.key, field.key_size);
+      out.append(':');
+      append_value(out, field, true);
+    }
+    out.append('}');
+    break;
+  }
+  out.append('\n');
+}
+
+} } // namespace ku::log
@@ -0,0 +1,23 @@
+/***************************************************************
+ * Copyright 2011, Zhang, Jun. All rights reserved.            *
+ * Author: Zhang, Jun (ralph dot j dot zhang at gmail dot com) *
+ *                                                             *
+ * This source code is provided with absolutely no warranty.   *
+ ***************************************************************/ 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "sink.hpp"
+#include "buffer.hpp"
+
+namespace ku { namespace log {
+
+// =======================================================================================
+// Renders one collected message in format and appends it to out.
+// message is the contiguous message as collected by Collector: time, level, then text
+// mixed with field_count binary fields (see field.hpp), ending with '\n'.
+// This runs on the writer thread, producers never pay for it.
+// =======================================================================================
+void render(Format format, char const* message, size_t size, uint32_t field_count, Buffer& out);
+
+} } // namespace ku::log
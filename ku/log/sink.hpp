@@ -16,20 +16,56 @@ class BufferList;
 class Sink;
 using Sink_ptr = std::unique_ptr<Sink>;
 
+// Summary of the messages in one write, times are nanoseconds since epoch
+struct WriteInfo
+{
+  WriteInfo() : begin_time(0), end_time(0), level_mask(0) { }
+
+  void add(LogLevel level, uint64_t time)
+  {
+    begin_time = begin_time && begin_time < time ? begin_time : time;
+    end_time = end_time > time ? end_time : time;
+    level_mask |= 1u << static_cast<uint32_t>(level);
+  }
+
+  uint64_t begin_time, end_time;
+  uint32_t level_mask; // bit n is set if any message is of LogLevel n
+};
+
+// =======================================================================================
+// Sink Format decides how messages are rendered before being written:
+//   Text: messages as collected, structured fields rendered as " key=value" after the text
+//   Logfmt: ts="..." level=Info msg="..." key=value ...
+//   Json: {"ts":"...","level":"Info","msg":"...","key":value,...}
+// Text messages without fields are written zero-copy, everything else is rendered by
+// the writer thread.
+// =======================================================================================
+enum class Format : uint8_t
+{
+  Text, Logfmt, Json
+};
+
 class Sink : private util::noncopyable
 {
 public:
-  Sink(LogLevel log_level) : log_level_(log_level) { }
+  Sink(LogLevel log_level, Format format = Format::Text)
+    : log_level_(log_level), format_(format) { }
 
   virtual ~Sink() { }
 
   virtual void write(BufferList const& list) = 0;
+  // Sinks interested in what is being written override this one
+  virtual void write(BufferList const& list, WriteInfo const&) { write(list); }
 
   LogLevel log_level() { return log_level_; }
   void set_log_level(LogLevel log_level) { log_level_ = log_level; }
 
+  Format format() const { return format_; }
+  void set_format(Format format) { format_ = format; }
+
 private:
   LogLevel log_level_;
+  Format format_;
 };
 
 } } // namespace ku::log
@@ -5,8 +5,11 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #include <sys/time.h>
+#include <sched.h>
+#include <unistd.h>
 #include <ctime>
 #include <cstdio>
+#include <vector>
 #include "util.hpp"
 
 namespace {
@@ -19,16 +22,47 @@ inline size_t to_str(char* buf, unsigned num, size_t size)
   }
   return size;
 }
+
+// cpu -> NUMA node, from the cpulist of each node, e.g. "0-3,8-11"
+std::vector<uint32_t> cpu_nodes()
+{
+  std::vector<uint32_t> nodes;
+  uint32_t const node_count = ku::log::util::numa_node_count();
+  for (uint32_t node = 0; node < node_count; ++node) {
+    char path[64];
+    ::snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+    FILE* file = ::fopen(path, "r");
+    if (!file)
+      continue;
+    unsigned first, last;
+    while (::fscanf(file, "%u", &first) == 1) {
+      last = first;
+      int c = ::fgetc(file);
+      if (c == '-') {
+        if (::fscanf(file, "%u", &last) != 1)
+          break;
+        c = ::fgetc(file);
+      }
+      if (nodes.size() <= last)
+        nodes.resize(last + 1, 0);
+      for (unsigned cpu = first; cpu <= last; ++cpu)
+        nodes[cpu] = node;
+      if (c != ',')
+        break;
+    }
+    ::fclose(file);
+  }
+  return nodes;
+}
 } // unamed namespace
 
 namespace ku { namespace log { namespace util {
 
-size_t now(char* buf)
+size_t format_time(char* buf, uint64_t nanoseconds)
 {
-  timespec ts;
-  ::clock_gettime(CLOCK_REALTIME, &ts);
+  time_t seconds = nanoseconds / 1000000000ULL;
   tm t;
-  ::localtime_r(&ts.tv_sec, &t);
+  ::localtime_r(&seconds, &t);
   char* p = buf;
   p += to_str(p, t.tm_year + 1900, 4);
   *p++ = '-';
@@ -42,10 +76,50 @@ size_t now(char* buf)
   *p++ = ':';
   p += to_str(p, t.tm_sec, 2);
   *p++ = '.';
-  p += to_str(p, ts.tv_nsec, 9);
+  p += to_str(p, nanoseconds % 1000000000ULL, 9);
   return p - buf;
 }
 
+size_t now(char* buf, uint64_t& nanoseconds)
+{
+  timespec ts;
+  ::clock_gettime(CLOCK_REALTIME, &ts);
+  nanoseconds = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  return format_time(buf, nanoseconds);
+}
+
+size_t now(char* buf)
+{
+  uint64_t nanoseconds;
+  return now(buf, nanoseconds);
+}
+
+bool parse_time(char const* str, uint64_t& nanoseconds)
+{
+  tm t = tm();
+  int consumed = 0;
+  if (::sscanf(str, "%4d-%2d-%2d %2d:%2d:%2d%n", &t.tm_year, &t.tm_mon, &t.tm_mday,
+               &t.tm_hour, &t.tm_min, &t.tm_sec, &consumed) != 6)
+    return false;
+  t.tm_year -= 1900;
+  t.tm_mon -= 1;
+  t.tm_isdst = -1;
+  time_t seconds = ::mktime(&t);
+  if (seconds == -1)
+    return false;
+  uint64_t fraction = 0;
+  str += consumed;
+  if (*str == '.') {
+    unsigned digits = 0;
+    for (++str; *str >= '0' && *str <= '9' && digits < 9; ++str, ++digits)
+      fraction = fraction * 10 + (*str - '0');
+    for (; digits < 9; ++digits)
+      fraction *= 10;
+  }
+  nanoseconds = seconds * 1000000000ULL + fraction;
+  return true;
+}
+
 std::string now()
 {
   char buf[32];
@@ -53,5 +127,25 @@ std::string now()
   return std::string(buf);
 }
 
+uint32_t numa_node()
+{
+  // Read once, sched_getcpu() goes through the vDSO (or rseq), no syscall per call
+  static std::vector<uint32_t> const nodes = cpu_nodes();
+  int cpu = ::sched_getcpu();
+  return cpu >= 0 && size_t(cpu) < nodes.size() ? nodes[cpu] : 0;
+}
+
+uint32_t numa_node_count()
+{
+  // possible nodes are listed as "0" or "0-N"
+  FILE* file = ::fopen("/sys/devices/system/node/possible", "r");
+  if (!file)
+    return 1;
+  unsigned first = 0, last = 0;
+  int n = ::fscanf(file, "%u-%u", &first, &last);
+  ::fclose(file);
+  return n == 2 ? last + 1 : 1;
+}
+
 } } } // namespace ku::log::util
 
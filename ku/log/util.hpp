@@ -5,6 +5,7 @@
  * This source code is provided with absolutely no warranty.   *
  ***************************************************************/ 
 #pragma once
+#include <cstdint>
 #include <atomic>
 #include <string>
 
@@ -25,9 +26,20 @@ struct noncopyable
 };
 
 size_t now(char* buf);
+// Also gives the time as nanoseconds since epoch
+size_t now(char* buf, uint64_t& nanoseconds);
+// Formats nanoseconds since epoch the same way as now(), returns the size written
+size_t format_time(char* buf, uint64_t nanoseconds);
+// Parses "YYYY-MM-DD HH:MM:SS[.fraction]" in local time, returns false on bad input
+bool parse_time(char const* str, uint64_t& nanoseconds);
 
 std::string now();
 
+// NUMA node of the CPU the calling thread is running on
+uint32_t numa_node();
+// Number of possible NUMA nodes on this host, 1 if the host isn't NUMA
+uint32_t numa_node_count();
+
 struct LineNo { using type = uint32_t; };
 
 template <typename T>
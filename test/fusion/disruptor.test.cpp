@@ -1,15 +1,50 @@
 #include <utest.hpp>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <vector>
 #include <ku/fusion/disruptor/sequence.hpp>
 #include <ku/fusion/disruptor/ring_buffer.hpp>
 #include <ku/fusion/disruptor/claimer.hpp>
 #include <ku/fusion/disruptor/waiting.hpp>
+#include <ku/fusion/disruptor/event_processor.hpp>
+#include <ku/fusion/disruptor/topology.hpp>
+#include <ku/fusion/disruptor/event_publisher.hpp>
+#include <ku/fusion/disruptor/work_processor.hpp>
+#include <ku/fusion/disruptor/shm_ring_buffer.hpp>
+#include <ku/fusion/disruptor/sequence_tuple.hpp>
 
 
 using namespace ku::fusion::disruptor;
 
 TEST(Sequence, sequence)
 {
+  std::unique_ptr<Sequence> heap(new Sequence(0));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(heap.get()) % 128);
+  struct { Sequence a{1u}, b{2u}; } pair;
+  EXPECT_EQ(128, reinterpret_cast<char*>(&pair.b) - reinterpret_cast<char*>(&pair.a));
 
+  pair.a.set(3);
+  EXPECT_EQ(3u, pair.a.get_relaxed());
+  pair.a.set_fenced(4);
+  EXPECT_EQ(4u, pair.a.get());
+  EXPECT_EQ(4u, pair.a.fetch_add(2));
+  EXPECT_TRUE(pair.a.cas(6, 7));
+  EXPECT_FALSE(pair.a.cas(6, 8));
+
+  SequenceList list;
+  list.initialize({ &pair.a, &pair.b });
+  EXPECT_EQ(2u, list.min_sequence());
+  EXPECT_EQ(7u, list.max_sequence());
+  EXPECT_TRUE(list.remove(&pair.b));
+  EXPECT_EQ(7u, list.min_sequence());
 }
 
 struct Entry
@@ -60,3 +95,741 @@ TEST(RingBuffer, claim_next)
   EXPECT_EQ(CAP + 3, buffer.cursor()); // then cursor should move further 3 slots
 }
 
+
+namespace {
+
+// One producer, a consumer, and a second consumer depending on the first
+template <typename Waiting, typename Storage = VectorStorage>
+void pipeline(size_t const Count = 100000)
+{
+  RingBuffer<Entry, Waiting, Claimer, Storage> buffer(64);
+  size_t const first = buffer.cursor() + 1;
+  Sequence seq1(buffer.cursor()), seq2(buffer.cursor());
+  buffer.set_gatings({&seq2});
+  SequenceList deps;
+  deps.initialize({&seq1});
+
+  int64_t sum1 = 0, sum2 = 0;
+  std::thread consumer1([&]() {
+    for (size_t seq = first; seq < first + Count; ) {
+      size_t available = buffer.wait_for(seq);
+      for (; seq <= available; ++seq)
+        sum1 += buffer[seq].data;
+      seq1.set(available);
+    }
+  });
+  std::thread consumer2([&]() {
+    for (size_t seq = first; seq < first + Count; ) {
+      size_t available = buffer.wait_for(seq, deps);
+      for (; seq <= available; ++seq)
+        sum2 += buffer[seq].data;
+      seq2.set(available);
+    }
+  });
+  for (size_t n = 0; n < Count; ++n) {
+    size_t seq = buffer.claim_next();
+    buffer[seq].data = n;
+    buffer.publish(seq);
+  }
+  consumer1.join();
+  consumer2.join();
+  int64_t const expected = int64_t(Count) * (Count - 1) / 2;
+  EXPECT_EQ(expected, sum1);
+  EXPECT_EQ(expected, sum2);
+}
+
+} // unamed namespace
+
+TEST(Waiting, busy_spin) { pipeline<BusySpinWaiting>(1000); } // slow without a core each
+TEST(Waiting, yield) { pipeline<YieldWaiting>(); }
+TEST(Waiting, phased) { pipeline<PhasedWaiting>(); }
+TEST(Waiting, futex) { pipeline<FutexWaiting>(); }
+TEST(Waiting, condition) { pipeline<ConditionWaiting>(); }
+TEST(Waiting, timeout_blocking) { pipeline<TimeoutBlockingWaiting>(); }
+
+TEST(RingBuffer, telemetry)
+{
+  RingBuffer<Entry, YieldWaiting> buffer(4);
+  Sequence seq1(buffer.cursor()), seq2(buffer.cursor());
+  buffer.set_gatings({&seq1, &seq2});
+  for (int n = 0; n < 4; ++n)
+    buffer.publish(buffer.claim_next());
+  seq2.set(buffer.cursor() - 1);
+
+  auto telemetry = buffer.telemetry();
+  EXPECT_EQ(4u, telemetry.capacity);
+  EXPECT_EQ(4u, telemetry.occupancy);
+  ASSERT_EQ(2u, telemetry.lags.size());
+  EXPECT_EQ(4u, telemetry.lags[0]);
+  EXPECT_EQ(1u, telemetry.lags[1]);
+  EXPECT_EQ(0u, telemetry.publisher.waits);
+
+  std::thread publisher([&]() { buffer.publish(buffer.claim_next()); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  seq1.set(buffer.cursor());
+  publisher.join();
+  telemetry = buffer.telemetry();
+  EXPECT_EQ(1u, telemetry.publisher.waits);
+  EXPECT_LT(0, telemetry.publisher.waited.count());
+  EXPECT_EQ(4u, telemetry.publisher.max_occupancy);
+  EXPECT_EQ(0u, telemetry.consumers.waits);
+}
+
+TEST(Storage, padded)
+{
+  RingBuffer<Entry, YieldWaiting, Claimer, PaddedStorage<128>> buffer(16);
+  char const* first = reinterpret_cast<char const*>(&buffer[0]);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(first) % 128);
+  EXPECT_EQ(128, reinterpret_cast<char const*>(&buffer[1]) - first);
+  EXPECT_EQ(first, reinterpret_cast<char const*>(&buffer[16]));
+  pipeline<YieldWaiting, PaddedStorage<64>>(10000);
+}
+
+TEST(Storage, huge_page)
+{
+  RingBuffer<Entry, YieldWaiting, Claimer, HugePageStorage<>> buffer(16);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&buffer[0]) % HugePageMemory::PageSize);
+  EXPECT_EQ(sizeof(Entry), reinterpret_cast<char const*>(&buffer[1]) - reinterpret_cast<char const*>(&buffer[0]));
+  pipeline<YieldWaiting, HugePageStorage<64>>(10000);
+}
+
+TEST(Storage, column)
+{
+  using Event = std::tuple<int, double>;
+  using Buffer = RingBuffer<Event, YieldWaiting, Claimer, ColumnStorage>;
+  Buffer buffer(16);
+  Sequence seq1(buffer.cursor());
+  buffer.set_gatings({&seq1});
+  EventPublisher<Buffer> publisher(buffer);
+  publisher.publish(Event(1, 0.5));
+  publisher.publish_event([](Buffer::Reference event, size_t seq, int n) {
+    std::get<0>(event) = n;
+    std::get<1>(event) = n / 2.0;
+  }, 3);
+
+  size_t const first = buffer.cursor() - 1;
+  EXPECT_EQ(1, std::get<0>(buffer[first]));
+  EXPECT_EQ(0.5, std::get<1>(buffer[first]));
+  EXPECT_EQ(3, std::get<0>(buffer[first + 1]));
+  EXPECT_EQ(1.5, std::get<1>(buffer[first + 1]));
+  Buffer const& cbuffer = buffer;
+  EXPECT_EQ(&std::get<0>(buffer[first]) + 1, &std::get<0>(cbuffer[first + 1]));
+}
+
+TEST(Waiting, timeout)
+{
+  RingBuffer<Entry, TimeoutBlockingWaiting> buffer(16);
+  buffer.waiting().set_timeout(std::chrono::milliseconds(10));
+  size_t const next = buffer.cursor() + 1;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_GT(next, buffer.wait_for(next));
+  EXPECT_LE(std::chrono::milliseconds(10), std::chrono::steady_clock::now() - start);
+
+  Sequence seq1(buffer.cursor());
+  SequenceList deps;
+  deps.initialize({&seq1});
+  buffer.publish(next);
+  EXPECT_EQ(next, buffer.wait_for(next));
+  EXPECT_GT(next, buffer.wait_for(next, deps)); // published, but not processed by deps
+  seq1.set(next);
+  EXPECT_EQ(next, buffer.wait_for(next, deps));
+}
+
+namespace {
+
+template <typename Waiting>
+void longer_timeout(Waiting&) { }
+void longer_timeout(TimeoutBlockingWaiting& waiting) { waiting.set_timeout(std::chrono::seconds(1)); }
+
+// A consumer blocked in wait_for leaves once alerted, or at the deadline
+template <typename Waiting>
+void stop_waiting()
+{
+  RingBuffer<Entry, Waiting> buffer(16);
+  longer_timeout(buffer.waiting());
+  size_t const next = buffer.cursor() + 1;
+  std::atomic<bool> alerted(false);
+  size_t available = next;
+  std::thread consumer([&]() { available = buffer.wait_for(next, SequenceList(), WaitStop(&alerted)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  alerted = true;
+  buffer.waiting().notify_all();
+  consumer.join();
+  EXPECT_GT(next, available);
+
+  alerted = false;
+  auto const start = WaitStop::Clock::now();
+  WaitStop const stop(&alerted, start + std::chrono::milliseconds(5));
+  EXPECT_GT(next, buffer.wait_for(next, SequenceList(), stop));
+  EXPECT_LE(std::chrono::milliseconds(5), WaitStop::Clock::now() - start);
+}
+
+} // unamed namespace
+
+TEST(Waiting, stop)
+{
+  stop_waiting<BusySpinWaiting>();
+  stop_waiting<YieldWaiting>();
+  stop_waiting<PhasedWaiting>();
+  stop_waiting<FutexWaiting>();
+  stop_waiting<ConditionWaiting>();
+  stop_waiting<TimeoutBlockingWaiting>();
+}
+
+TEST(RingBuffer, wait_for_capacity)
+{
+  RingBuffer<Entry, YieldWaiting> buffer(4);
+  Sequence seq1(buffer.cursor());
+  buffer.set_gatings({&seq1});
+  EXPECT_TRUE(buffer.wait_for_capacity(4));
+  buffer.publish(buffer.claim_next(4));
+
+  auto const start = WaitStop::Clock::now();
+  EXPECT_FALSE(buffer.wait_for_capacity(1, WaitStop(nullptr, start + std::chrono::milliseconds(5))));
+  EXPECT_LE(std::chrono::milliseconds(5), WaitStop::Clock::now() - start);
+  seq1.set(buffer.cursor() - 3);
+  EXPECT_TRUE(buffer.wait_for_capacity(1, WaitStop(nullptr, start)));
+}
+
+TEST(MultiClaimer, out_of_order_publish)
+{
+  size_t const CAP = 16u;
+  RingBuffer<Entry, YieldWaiting, MultiClaimer> buffer(CAP);
+  Sequence seq1(buffer.cursor());
+  buffer.set_gatings({&seq1});
+
+  size_t first = buffer.claim_next();
+  size_t second = buffer.claim_next();
+  EXPECT_EQ(CAP, first);
+  EXPECT_EQ(CAP + 1, second);
+  EXPECT_EQ(CAP + 1, buffer.cursor()); // cursor is the highest claimed
+  buffer.publish(second);
+  EXPECT_EQ(first - 1, buffer.wait_for(first)); // first not published, nothing available
+  buffer.publish(first);
+  EXPECT_EQ(second, buffer.wait_for(first));
+
+  size_t last = buffer.claim_next(3);
+  EXPECT_EQ(CAP + 4, last);
+  buffer.publish(last - 2, last);
+  EXPECT_EQ(last, buffer.wait_for(second + 1));
+
+  // Next round of the same slots isn't published until written again
+  seq1.set(last);
+  for (size_t n = 0; n < CAP; ++n)
+    buffer.publish(buffer.claim_next());
+  EXPECT_EQ(last + CAP, buffer.wait_for(last + 1));
+  EXPECT_FALSE(buffer.has_available(1));
+}
+
+TEST(MultiClaimer, producers)
+{
+  size_t const Count = 10000, Producers = 3;
+  RingBuffer<Entry, YieldWaiting, MultiClaimer> buffer(64);
+  size_t const first = buffer.cursor() + 1;
+  Sequence consumed(buffer.cursor());
+  buffer.set_gatings({&consumed});
+
+  int64_t sum = 0;
+  std::thread consumer([&]() {
+    for (size_t seq = first; seq < first + Count * Producers; ) {
+      size_t available = buffer.wait_for(seq);
+      for (; seq <= available; ++seq)
+        sum += buffer[seq].data;
+      consumed.set(available);
+    }
+  });
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < Producers; ++p) {
+    producers.emplace_back([&]() {
+      for (size_t n = 0; n < Count; ++n) {
+        size_t seq = buffer.claim_next();
+        buffer[seq].data = n;
+        buffer.publish(seq);
+      }
+    });
+  }
+  for (auto& producer : producers)
+    producer.join();
+  consumer.join();
+  EXPECT_EQ(int64_t(Producers * Count * (Count - 1) / 2), sum);
+}
+
+TEST(BatchEventProcessor, run)
+{
+  size_t const Count = 10000;
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(64);
+  size_t const first = buffer.cursor() + 1;
+
+  struct Handler
+  {
+    void operator()(Entry& event, size_t seq, bool end_of_batch)
+    {
+      sum += event.data;
+      last_seq = seq;
+      batches += end_of_batch;
+    }
+    int64_t sum = 0;
+    size_t last_seq = 0, batches = 0;
+  };
+  BatchEventProcessor<Buffer, Handler> processor(buffer, Handler());
+  buffer.set_gatings({&processor.sequence()});
+  std::thread consumer([&]() { processor.run(); });
+
+  for (size_t n = 0; n < Count; ++n) {
+    size_t seq = buffer.claim_next();
+    buffer[seq].data = n;
+    buffer.publish(seq);
+  }
+  while (processor.sequence().get() != first + Count - 1)
+    std::this_thread::yield();
+  processor.halt();
+  size_t seq = buffer.claim_next(); // wakes the processor to see halt
+  buffer[seq].data = 0;
+  buffer.publish(seq);
+  consumer.join();
+
+  Handler& handler = processor.handler();
+  EXPECT_EQ(first + Count, handler.last_seq);
+  EXPECT_EQ(int64_t(Count) * (Count - 1) / 2, handler.sum);
+  EXPECT_LE(2u, handler.batches);
+  EXPECT_GE(Count + 1, handler.batches);
+}
+
+TEST(BatchEventProcessor, dependencies)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  std::vector<size_t> order;
+  auto first = [&](Entry& event, size_t, bool) { event.data *= 2; };
+  auto second = [&](Entry& event, size_t, bool) {
+    order.push_back(event.data);
+  };
+  BatchEventProcessor<Buffer, decltype(first)> processor1(buffer, first);
+  BatchEventProcessor<Buffer, decltype(second)> processor2(buffer, second);
+  processor2.set_dependencies({&processor1.sequence()});
+  buffer.set_gatings({&processor2.sequence()});
+  std::thread consumer1([&]() { processor1.run(); });
+  std::thread consumer2([&]() { processor2.run(); });
+
+  for (int n = 0; n < 100; ++n) {
+    size_t seq = buffer.claim_next();
+    buffer[seq].data = n;
+    buffer.publish(seq);
+  }
+  while (processor2.sequence().get() != buffer.cursor())
+    std::this_thread::yield();
+  processor1.halt();
+  processor2.halt();
+  size_t seq = buffer.claim_next(); // wakes the processors to see halt
+  buffer[seq].data = 100;
+  buffer.publish(seq);
+  consumer1.join();
+  consumer2.join();
+
+  ASSERT_EQ(101u, order.size());
+  for (int n = 0; n < 100; ++n)
+    EXPECT_EQ(size_t(n * 2), order[n]);
+}
+
+namespace {
+
+struct Heartbeat
+{
+  void operator()(Entry&, size_t, bool) { ++events; }
+  void on_timeout(size_t) { ++timeouts; }
+
+  int events = 0, timeouts = 0;
+};
+
+} // unamed namespace
+
+TEST(BatchEventProcessor, halt_and_timeout)
+{
+  using Buffer = RingBuffer<Entry, FutexWaiting>;
+  Buffer buffer(16);
+  BatchEventProcessor<Buffer, Heartbeat> processor(buffer, Heartbeat());
+  buffer.set_gatings({&processor.sequence()});
+  processor.set_timeout(std::chrono::milliseconds(1));
+  std::thread consumer([&]() { processor.run(); });
+
+  buffer.publish(buffer.claim_next());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  processor.halt(); // wakes it up, no event needed
+  consumer.join();
+  EXPECT_EQ(1, processor.handler().events);
+  EXPECT_LE(1, processor.handler().timeouts);
+}
+
+TEST(Topology, diamond)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  std::atomic<int> journalled(0), replicated(0);
+  std::vector<int> seen; // by logic, after both
+  auto journaller = [&](Entry& event, size_t, bool) { journalled = event.data; };
+  auto replicator = [&](Entry& event, size_t, bool) { replicated = event.data; };
+  auto logic = [&](Entry& event, size_t, bool) {
+    EXPECT_LE(event.data, journalled.load());
+    EXPECT_LE(event.data, replicated.load());
+    seen.push_back(event.data);
+  };
+  size_t logs = 0;
+  auto audit = [&](Entry&, size_t, bool) { ++logs; };
+
+  {
+    Topology<Buffer> topology(buffer);
+    auto input = topology.handle_with(journaller, replicator);
+    auto output = topology.after(input).handle_with(logic);
+    topology.after(output).handle_with(audit);
+    EXPECT_EQ(4u, topology.processors().size());
+    ASSERT_EQ(1u, topology.leaves().size());
+    EXPECT_EQ(&topology.processors()[3]->sequence(), topology.leaves()[0]);
+    topology.start();
+
+    for (int n = 0; n < 1000; ++n) {
+      size_t seq = buffer.claim_next();
+      buffer[seq].data = n;
+      buffer.publish(seq);
+    }
+    while (topology.leaves()[0]->get() != buffer.cursor())
+      std::this_thread::yield();
+    topology.halt();
+    size_t seq = buffer.claim_next(); // wakes processors to see halt
+    buffer[seq].data = 1000;
+    buffer.publish(seq);
+  }
+  ASSERT_EQ(1001u, seen.size());
+  for (int n = 0; n <= 1000; ++n)
+    EXPECT_EQ(n, seen[n]);
+  EXPECT_EQ(1001u, logs);
+}
+
+TEST(SequenceTuple, diamond)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  std::atomic<int> journalled(0), replicated(0);
+  std::vector<int> seen;
+  auto journaller = [&](Entry& event, size_t, bool) { journalled = event.data; };
+  auto replicator = [&](Entry& event, size_t, bool) { replicated = event.data; };
+  auto logic = [&](Entry& event, size_t, bool) {
+    EXPECT_LE(event.data, journalled.load());
+    EXPECT_LE(event.data, replicated.load());
+    seen.push_back(event.data);
+  };
+
+  BatchEventProcessor<Buffer, decltype(journaller)> journal(buffer, journaller);
+  BatchEventProcessor<Buffer, decltype(replicator)> replicate(buffer, replicator);
+  auto both = make_sequence_tuple(journal, replicate);
+  BatchEventProcessor<Buffer, decltype(logic), decltype(both)> business(buffer, logic, both);
+  auto gating = make_sequence_tuple(business);
+  EXPECT_EQ(buffer.cursor(), gating.min_sequence());
+
+  std::thread t1([&]() { journal.run(); }), t2([&]() { replicate.run(); }), t3([&]() { business.run(); });
+  for (int n = 0; n < 1000; ++n) {
+    size_t seq = buffer.claim_next(1, gating);
+    buffer[seq].data = n;
+    buffer.publish(seq);
+  }
+  while (gating.min_sequence() != buffer.cursor())
+    std::this_thread::yield();
+  journal.halt();
+  replicate.halt();
+  business.halt();
+  size_t seq = buffer.claim_next(1, gating); // wakes processors to see halt
+  buffer[seq].data = 1000;
+  buffer.publish(seq);
+  t1.join();
+  t2.join();
+  t3.join();
+
+  ASSERT_EQ(1001u, seen.size());
+  for (int n = 0; n <= 1000; ++n)
+    EXPECT_EQ(n, seen[n]);
+}
+
+TEST(Topology, leaves)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  auto handler = [](Entry&, size_t, bool) { };
+  Topology<Buffer> topology(buffer);
+  auto a = topology.handle_with(handler);
+  auto bc = a.then(handler, handler);
+  auto d = topology.handle_with(handler);
+  EXPECT_EQ(2u, bc.sequences().size());
+  std::vector<Sequence*> leaves = topology.leaves();
+  ASSERT_EQ(3u, leaves.size());
+  EXPECT_EQ(bc.sequences()[0], leaves[0]);
+  EXPECT_EQ(bc.sequences()[1], leaves[1]);
+  EXPECT_EQ(d.sequences()[0], leaves[2]);
+  auto e = topology.after(bc, d).then(handler);
+  EXPECT_EQ(e.sequences(), topology.leaves());
+}
+
+TEST(EventPublisher, publish)
+{
+  size_t const CAP = 16u;
+  RingBuffer<Entry, YieldWaiting> buffer(CAP);
+  Sequence seq1(buffer.cursor());
+  buffer.set_gatings({&seq1});
+  EventPublisher<RingBuffer<Entry, YieldWaiting>> publisher(buffer);
+
+  publisher.publish(Entry{ 42 });
+  EXPECT_EQ(CAP, buffer.cursor());
+  EXPECT_EQ(42, buffer[CAP].data);
+
+  publisher.publish_event([](Entry& event, size_t seq, int a, int b) { event.data = a + b; }, 1, 2);
+  EXPECT_EQ(CAP + 1, buffer.cursor());
+  EXPECT_EQ(3, buffer[CAP + 1].data);
+
+  std::vector<int> updates = { 5, 6, 7 };
+  publisher.publish_events(updates.begin(), updates.end(),
+                           [](Entry& event, size_t, int update) { event.data = update; });
+  EXPECT_EQ(CAP + 4, buffer.cursor());
+  for (int n = 0; n < 3; ++n)
+    EXPECT_EQ(5 + n, buffer[CAP + 2 + n].data);
+
+  seq1.set(buffer.cursor());
+  publisher.publish_events(2, [](Entry& event, size_t, size_t n) { event.data = n; });
+  EXPECT_EQ(CAP + 6, buffer.cursor());
+  EXPECT_EQ(1, buffer[CAP + 6].data);
+
+  EXPECT_THROW(publisher.publish_event([](Entry&, size_t) { throw 1; }), int);
+  EXPECT_EQ(CAP + 7, buffer.cursor()); // published anyway
+}
+
+TEST(EventPublisher, batches)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting, MultiClaimer>;
+  Buffer buffer(16);
+  EventPublisher<Buffer> publisher(buffer);
+  int64_t sum = 0;
+  size_t batches = 0;
+  auto handler = [&](Entry& event, size_t, bool end_of_batch) {
+    sum += event.data;
+    batches += end_of_batch;
+  };
+  BatchEventProcessor<Buffer, decltype(handler)> processor(buffer, handler);
+  buffer.set_gatings({&processor.sequence()});
+  std::thread consumer([&]() { processor.run(); });
+
+  std::vector<int> packet(100);
+  for (int n = 0; n < 100; ++n)
+    packet[n] = n;
+  publisher.publish_events(packet.begin(), packet.end(),
+                           [](Entry& event, size_t, int update) { event.data = update; });
+  while (processor.sequence().get() != buffer.cursor())
+    std::this_thread::yield();
+  processor.halt();
+  publisher.publish(Entry{ 0 });
+  consumer.join();
+  EXPECT_EQ(4950, sum);
+  EXPECT_LE(1u, batches);
+}
+
+TEST(WorkerPool, exactly_once)
+{
+  size_t const Count = 3000, Workers = 3;
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(64);
+  std::vector<std::atomic<int>> hits(Count + Workers);
+  for (auto& hit : hits)
+    hit = 0;
+  std::atomic<size_t> handled(0);
+  auto handler = [&](Entry& event, size_t) { ++hits[event.data]; ++handled; };
+
+  WorkerPool<Buffer, decltype(handler)> pool(buffer, Workers, handler);
+  buffer.set_gatings(pool.sequences());
+  pool.start();
+  EventPublisher<Buffer> publisher(buffer);
+  publisher.publish_events(Count, [](Entry& event, size_t, size_t n) { event.data = n; });
+  while (handled != Count)
+    std::this_thread::yield();
+  pool.halt();
+  // Each worker waits for a sequence of its own, wakes them all to see halt
+  publisher.publish_events(Workers, [](Entry& event, size_t, size_t n) { event.data = Count + n; });
+  pool.join();
+
+  for (size_t n = 0; n < Count; ++n)
+    ASSERT_EQ(1, hits[n]) << "event " << n;
+}
+
+TEST(Topology, pool)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  std::atomic<int> journalled(-1);
+  std::atomic<size_t> validated(0);
+  auto journaller = [&](Entry& event, size_t, bool) { journalled = event.data; };
+  auto validator = [&](Entry& event, size_t) {
+    EXPECT_LE(event.data, journalled.load());
+    ++validated;
+  };
+
+  Topology<Buffer> topology(buffer);
+  auto pool = topology.handle_with(journaller).then_pool(2, validator);
+  EXPECT_EQ(2u, pool.sequences().size());
+  EXPECT_EQ(pool.sequences(), topology.leaves());
+  topology.start();
+  EventPublisher<Buffer> publisher(buffer);
+  publisher.publish_events(1000, [](Entry& event, size_t, size_t n) { event.data = n; });
+  while (validated != 1000)
+    std::this_thread::yield();
+  topology.halt();
+  publisher.publish_events(2, [](Entry& event, size_t, size_t n) { event.data = 1000 + n; });
+  topology.join();
+  EXPECT_LE(999, journalled.load());
+}
+
+TEST(RingBuffer, add_remove_gating)
+{
+  size_t const CAP = 16u;
+  RingBuffer<Entry, YieldWaiting> buffer(CAP);
+  Sequence seq1(buffer.cursor());
+  buffer.set_gatings({&seq1});
+  for (int n = 0; n < 10; ++n)
+    buffer.publish(buffer.claim_next());
+  seq1.set(buffer.cursor());
+
+  Sequence late(0);
+  buffer.add_gating(late);
+  EXPECT_EQ(buffer.cursor(), late.get()); // joins at the cursor
+  EXPECT_TRUE(buffer.has_available(CAP));
+  buffer.publish(buffer.claim_next());
+  seq1.set(buffer.cursor());
+  EXPECT_FALSE(buffer.has_available(CAP)); // gated by the late comer
+
+  EXPECT_TRUE(buffer.remove_gating(late));
+  EXPECT_FALSE(buffer.remove_gating(late));
+  EXPECT_TRUE(buffer.has_available(CAP));
+
+  // Publisher runs freely with no consumer at all
+  EXPECT_TRUE(buffer.remove_gating(seq1));
+  for (size_t n = 0; n < CAP * 2; ++n)
+    buffer.publish(buffer.claim_next());
+  EXPECT_TRUE(buffer.has_available(CAP));
+}
+
+TEST(RingBuffer, late_consumer)
+{
+  using Buffer = RingBuffer<Entry, YieldWaiting>;
+  Buffer buffer(16);
+  EventPublisher<Buffer> publisher(buffer);
+  std::atomic<size_t> first_seen(0), last_seen(0);
+  auto handler = [&](Entry&, size_t seq, bool) {
+    size_t expected = 0;
+    first_seen.compare_exchange_strong(expected, seq);
+    last_seen = seq;
+  };
+  auto skip = [&](Entry&, size_t, bool) { };
+  BatchEventProcessor<Buffer, decltype(skip)> early(buffer, skip);
+  buffer.set_gatings({&early.sequence()});
+  std::thread early_thread([&]() { early.run(); });
+  publisher.publish_events(100, [](Entry& event, size_t, size_t n) { event.data = n; });
+  size_t const joined_at = buffer.cursor();
+
+  BatchEventProcessor<Buffer, decltype(handler)> late(buffer, handler);
+  buffer.add_gating(late.sequence());
+  std::thread late_thread([&]() { late.run(); });
+  publisher.publish_events(100, [](Entry& event, size_t, size_t n) { event.data = n; });
+  while (late.sequence().get() != buffer.cursor())
+    std::this_thread::yield();
+  EXPECT_EQ(joined_at + 1, first_seen.load());
+
+  // Leaving doesn't stop the publisher
+  EXPECT_TRUE(buffer.remove_gating(late.sequence()));
+  late.halt();
+  publisher.publish_events(100, [](Entry& event, size_t, size_t n) { event.data = n; });
+  late_thread.join();
+  while (early.sequence().get() != buffer.cursor())
+    std::this_thread::yield();
+  early.halt();
+  publisher.publish(Entry{ 0 });
+  early_thread.join();
+}
+
+namespace {
+
+std::string shm_test_name()
+{
+  return "shm://ku_test_" + std::to_string(::getpid());
+}
+
+} // unamed namespace
+
+TEST(ShmRingBuffer, cross_process)
+{
+  size_t const Count = 10000;
+  std::string name = shm_test_name();
+  ShmRingBuffer<Entry> buffer(name.c_str(), 64, 4);
+  EXPECT_EQ(64u, buffer.capacity());
+  EXPECT_EQ(63u, buffer.cursor());
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    int64_t sum = 0;
+    {
+      ShmRingBuffer<Entry> consumer(name.c_str());
+      Sequence& seq = consumer.attach();
+      for (size_t next = seq.get() + 1; next < 64 + Count; ) {
+        size_t available = consumer.wait_for(next);
+        for (; next <= available; ++next)
+          sum += consumer[next].data;
+        seq.set(available);
+      }
+    }
+    ::_exit(sum == int64_t(Count) * (Count - 1) / 2 ? 0 : 1);
+  }
+
+  while (buffer.consumer_count() == 0)
+    std::this_thread::yield();
+  for (size_t n = 0; n < Count; ++n) {
+    size_t seq = buffer.claim_next();
+    buffer[seq].data = n;
+    buffer.publish(seq);
+  }
+  int status;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  EXPECT_EQ(0u, buffer.consumer_count());
+}
+
+TEST(ShmRingBuffer, dead_consumer)
+{
+  std::string name = shm_test_name();
+  ShmRingBuffer<Entry> buffer(name.c_str(), 16, 2);
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    ShmRingBuffer<Entry> consumer(name.c_str());
+    consumer.attach();
+    ::_exit(0); // dies attached
+  }
+  ASSERT_EQ(pid, ::waitpid(pid, nullptr, 0));
+  EXPECT_EQ(1u, buffer.consumer_count());
+
+  // Gated by the dead one, until the publisher reaps it waiting
+  for (size_t n = 0; n < buffer.capacity() * 2; ++n)
+    buffer.publish(buffer.claim_next());
+  EXPECT_EQ(0u, buffer.consumer_count());
+}
+
+TEST(ShmRingBuffer, header)
+{
+  std::string name = shm_test_name();
+  ShmRingBuffer<Entry> buffer(name.c_str(), 16);
+  EXPECT_THROW(ShmRingBuffer<Sequence*>(name.c_str()), std::system_error); // event size differs
+  EXPECT_THROW(ShmRingBuffer<Entry>("tcp://127.0.0.1:80"), std::system_error);
+  ShmRingBuffer<Entry> consumer(name.c_str());
+  EXPECT_TRUE(consumer.publisher_alive());
+  std::vector<Sequence*> seqs;
+  for (uint32_t n = 0; n < consumer.max_consumers(); ++n)
+    seqs.push_back(&consumer.attach());
+  EXPECT_THROW(consumer.attach(), std::system_error);
+  consumer.detach(*seqs[0]);
+  EXPECT_EQ(consumer.max_consumers() - 1, buffer.consumer_count());
+}
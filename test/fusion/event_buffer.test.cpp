@@ -150,3 +150,54 @@ TEST(EventBuffer, max_usable)
   EXPECT_EQ(end_seq - 1, eb.max_usable_block_sequence());
 }
 
+
+TEST(EventBuffer, wait_for)
+{
+  using namespace std::chrono;
+
+  EventBuffer eb(16);
+  Processor p1(eb.initial_sequence());
+  eb.barrier().add_processor(p1);
+  eb.barrier().set_spin_time(microseconds(0)); // blocks right away
+
+  size_t const next_seq = eb.initial_sequence() + 1;
+  size_t available = 0;
+  std::thread processor([&]{ available = eb.wait_for(next_seq); });
+  std::this_thread::sleep_for(milliseconds(1));
+  eb.claim(next_seq + 1);
+  eb.publish(next_seq + 1);
+  processor.join();
+  EXPECT_EQ(next_seq + 1, available);
+
+  // Alerted, returns below the sequence waited for
+  std::thread alerted([&]{ available = eb.wait_for(next_seq + 2); });
+  std::this_thread::sleep_for(milliseconds(1));
+  eb.barrier().alert();
+  alerted.join();
+  EXPECT_EQ(next_seq + 1, available);
+}
+
+TEST(EventBuffer, telemetry)
+{
+  EventBuffer eb(4);
+  Processor p1(eb.initial_sequence());
+  eb.barrier().add_processor(p1);
+  eb.set_wait_strategy([&](size_t count) { p1.seq.set(eb.published_sequence()); });
+
+  size_t claim_seq = eb.initial_sequence() + 3;
+  eb.claim(claim_seq);
+  eb.publish(claim_seq);
+  RingTelemetry telemetry = eb.telemetry();
+  EXPECT_EQ(4u, telemetry.capacity);
+  EXPECT_EQ(3u, telemetry.occupancy);
+  ASSERT_EQ(1u, telemetry.lags.size());
+  EXPECT_EQ(3u, telemetry.lags[0]);
+
+  // The slot of claim_seq + 2 is free once p1 catches up, in the wait strategy
+  eb.claim(claim_seq + 2);
+  telemetry = eb.telemetry();
+  EXPECT_EQ(1u, telemetry.publisher.waits);
+  EXPECT_EQ(1u, telemetry.publisher.histogram[0]);
+  EXPECT_EQ(0u, telemetry.lags[0]);
+  EXPECT_EQ(0u, telemetry.consumers.waits);
+}
@@ -0,0 +1,160 @@
+#include <utest.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ku/fusion/io_uring_poller.hpp>
+
+using namespace ku::fusion;
+
+namespace {
+
+struct RawHandle
+{
+  int fd;
+  int raw_handle() const { return fd; }
+};
+
+} // unamed namespace
+
+TEST(IoUringPollLoop, notices)
+{
+  if (!io_uring::supported())
+    return;
+  int const fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+  ASSERT_LE(0, fd);
+  io_uring::PollLoop loop;
+  int reads = 0;
+  loop.notices().add_notice(RawHandle{fd}, { Notice::Inbound },
+      [&](Notice::Event event, NoticeId id) {
+        EXPECT_EQ(Notice::Read, event);
+        // Level triggered, polled again till drained
+        if (++reads == 2) {
+          uint64_t val;
+          EXPECT_EQ(8, ::read(fd, &val, sizeof(val)));
+          loop.notices().remove_notice(id);
+          loop.quit();
+        }
+        return true;
+      });
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  EXPECT_EQ(2, reads);
+  ::close(fd);
+}
+
+TEST(IoUringPollLoop, sockets)
+{
+  if (!io_uring::supports_multishot())
+    return;
+  int const listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in addr = sockaddr_in();
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+  ASSERT_EQ(0, ::listen(listener, 4));
+  ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len));
+
+  io_uring::PollLoop loop;
+  loop.set_buffers(4, 64);
+  std::string received;
+  int sent = 0, accepted = -1;
+  char const reply1[] = "po", reply2[] = "ng";
+  std::vector<iovec> const reply = { { const_cast<char*>(reply1), 2 }, { const_cast<char*>(reply2), 2 } };
+  loop.accept(listener, [&](int fd) {
+    ASSERT_LE(0, fd);
+    accepted = fd;
+    loop.recv(fd, [&, fd](int res, char const* data) {
+      ASSERT_LT(0, res);
+      received.append(data, res);
+      if (received == "ping")
+        loop.send(fd, reply, [&](int res) { sent = res; loop.quit(); });
+    });
+  });
+
+  int const client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(0, ::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+  EXPECT_EQ(4, ::write(client, "ping", 4));
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  EXPECT_EQ("ping", received);
+  EXPECT_EQ(4, sent);
+  char buf[8];
+  EXPECT_EQ(4, ::read(client, buf, sizeof(buf)));
+  EXPECT_EQ("pong", std::string(buf, 4));
+  ::close(accepted);
+  ::close(client);
+  ::close(listener);
+}
+
+TEST(IoUringPollLoop, send_whole)
+{
+  if (!io_uring::supported())
+    return;
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds));
+  int const small = 4096;
+  ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+  ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+
+  // Far more than the socket buffers hold, each send is short at first
+  size_t const Size = 1 << 20;
+  std::vector<char> data(2 * Size);
+  for (size_t n = 0; n < data.size(); ++n)
+    data[n] = char(n % 251);
+  std::vector<char> received;
+  std::thread reader([&]() {
+    char buf[8192];
+    ssize_t size;
+    while (received.size() < data.size() && (size = ::read(fds[1], buf, sizeof(buf))) > 0)
+      received.insert(received.end(), buf, buf + size);
+  });
+
+  io_uring::PollLoop loop;
+  int sent = 0;
+  std::vector<iovec> const bufs = { { &data[0], Size }, { &data[Size], Size } };
+  loop.send(fds[0], bufs, [&](int res) { sent = res; loop.quit(); });
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  ::shutdown(fds[0], SHUT_WR); // the reader stops at the end, gap or not
+  reader.join();
+  EXPECT_EQ(int(data.size()), sent);
+  EXPECT_TRUE(received == data);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST(IoUringPollLoop, stale_cancel)
+{
+  if (!io_uring::supports_multishot())
+    return;
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds));
+  io_uring::PollLoop loop;
+  loop.set_buffers(4, 64);
+  char const ping[] = "ping";
+  std::vector<iovec> const bufs = { { const_cast<char*>(ping), 4 } };
+  bool sent = false;
+  io_uring::PollLoop::OpId const send = loop.send(fds[0], bufs, [&](int res) { sent = true; });
+  io_uring::PollLoop::OpId reply = 0;
+  std::string received;
+  loop.recv(fds[1], [&](int res, char const* data) {
+    ASSERT_TRUE(sent);
+    // Reuses the slot of the finished send, the late cancel of which leaves it alone
+    reply = loop.recv(fds[0], [&](int res, char const* data) {
+      received.append(data, res);
+      loop.quit();
+    });
+    loop.cancel(send);
+    EXPECT_EQ(4, ::write(fds[1], "pong", 4));
+  });
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  EXPECT_NE(send, reply);
+  EXPECT_EQ(uint32_t(send), uint32_t(reply));
+  EXPECT_EQ("pong", received);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
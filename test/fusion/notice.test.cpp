@@ -0,0 +1,112 @@
+#include <utest.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include <ku/fusion/notice_slab.hpp>
+#include <ku/fusion/epoll_poller.hpp>
+#include <ku/fusion/poll_poller.hpp>
+
+using namespace ku::fusion;
+
+TEST(NoticeSlab, generations)
+{
+  NoticeSlab slab;
+  NoticeId const id1 = slab.allocate(), id2 = slab.allocate();
+  EXPECT_NE(0u, id1);
+  EXPECT_NE(NoticeSlab::slot_of(id1), NoticeSlab::slot_of(id2));
+
+  Notice* notice = slab.insert(Notice(3, nullptr, id1));
+  EXPECT_EQ(notice, slab.find(id1));
+  EXPECT_EQ(3, notice->raw_handle());
+  EXPECT_EQ(nullptr, slab.find(id2)); // allocated, not inserted
+  EXPECT_EQ(1u, slab.size());
+
+  EXPECT_TRUE(slab.erase(id1));
+  EXPECT_FALSE(slab.erase(id1));
+  EXPECT_EQ(0u, slab.size());
+
+  // The slot is reused, the stale id doesn't find the new notice
+  NoticeId const id3 = slab.allocate();
+  EXPECT_EQ(NoticeSlab::slot_of(id1), NoticeSlab::slot_of(id3));
+  EXPECT_EQ(NoticeSlab::generation_of(id1) + 1, NoticeSlab::generation_of(id3));
+  slab.insert(Notice(4, nullptr, id3));
+  EXPECT_EQ(nullptr, slab.find(id1));
+  EXPECT_EQ(4, slab.find(id3)->raw_handle());
+}
+
+struct RawHandle
+{
+  int fd;
+  int raw_handle() const { return fd; }
+};
+
+TEST(EpollPollLoop, dispatch)
+{
+  int const fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+  ASSERT_LE(0, fd);
+  epoll::PollLoop loop;
+  int reads = 0;
+  NoticeId id = 0;
+  id = loop.notices().add_notice(RawHandle{fd}, { Notice::Inbound },
+      [&](Notice::Event event, NoticeId notice_id) {
+        EXPECT_EQ(id, notice_id);
+        if (event == Notice::Read && ++reads == 1) {
+          uint64_t val;
+          EXPECT_EQ(8, ::read(fd, &val, sizeof(val)));
+          loop.notices().remove_notice(notice_id);
+          loop.notices().remove_notice(notice_id + (NoticeId(1) << 32)); // stale, skipped
+          loop.quit();
+        }
+        return true;
+      });
+  EXPECT_EQ(0u, NoticeSlab::slot_of(id));
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  EXPECT_EQ(1, reads);
+  ::close(fd);
+}
+
+TEST(PollPollLoop, dispatch)
+{
+  int const Fds = 3;
+  int fds[Fds];
+  for (int& fd : fds) {
+    fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ASSERT_LE(0, fd);
+  }
+  poll::PollLoop loop;
+  std::vector<int> reads(Fds, 0);
+  NoticeId ids[Fds];
+  for (int n = 0; n < Fds; ++n) {
+    ids[n] = loop.notices().add_notice(RawHandle{fds[n]}, { Notice::Inbound },
+        [&, n](Notice::Event event, NoticeId notice_id) {
+          EXPECT_EQ(Notice::Read, event);
+          EXPECT_EQ(ids[n], notice_id);
+          uint64_t val;
+          EXPECT_EQ(8, ::read(fds[n], &val, sizeof(val)));
+          uint64_t const one = 1;
+          ++reads[n];
+          if (n == 0) {
+            // Readable again, but removed before the next round
+            loop.notices().remove_notice(notice_id);
+            EXPECT_EQ(8, ::write(fds[0], &one, sizeof(one)));
+          } else if (n == Fds - 1 && reads[n] == 1) {
+            // Next round it is polled in the hole left by the first
+            EXPECT_EQ(8, ::write(fds[n], &one, sizeof(one)));
+          } else if (n == Fds - 1) {
+            loop.quit();
+          }
+          return true;
+        });
+  }
+  uint64_t const one = 1;
+  for (int fd : fds)
+    EXPECT_EQ(8, ::write(fd, &one, sizeof(one)));
+
+  EXPECT_TRUE(loop(std::chrono::milliseconds(100)));
+  EXPECT_EQ(1, reads[0]);
+  EXPECT_EQ(1, reads[1]);
+  EXPECT_EQ(2, reads[2]);
+  for (int fd : fds)
+    ::close(fd);
+}
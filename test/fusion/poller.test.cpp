@@ -0,0 +1,71 @@
+#include <utest.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ku/fusion/poller.hpp>
+
+using namespace ku::fusion;
+
+TEST(EventProcessor, partition)
+{
+  epoll_event ev;
+  ev.data.u64 = 0;
+  for (int fd = 0; fd < 64; ++fd) {
+    ev.data.fd = fd;
+    size_t const n = EventProcessor::partition(ev, 3);
+    EXPECT_GT(3u, n);
+    EXPECT_EQ(n, EventProcessor::partition(ev, 3));
+  }
+}
+
+TEST(Poller, processors)
+{
+  int const Fds = 4, Writes = 100;
+  Poller poller(EPOLL_CLOEXEC, 16);
+  std::vector<int> fds;
+  for (int n = 0; n < Fds; ++n) {
+    fds.push_back(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = n;
+    ASSERT_TRUE(poller.add_event(fds.back(), &ev));
+  }
+
+  std::mutex mutex;
+  std::vector<std::thread::id> handled_by(Fds);
+  std::atomic<uint64_t> total(0);
+  bool same_thread = true;
+  poller.start(3, [&](epoll_event const& ev) {
+    uint64_t value;
+    if (::read(fds[ev.data.u64], &value, sizeof(value)) == sizeof(value))
+      total += value;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::thread::id& id = handled_by[ev.data.u64];
+    if (id == std::thread::id())
+      id = std::this_thread::get_id();
+    same_thread = same_thread && id == std::this_thread::get_id();
+  });
+  std::thread loop(std::ref(poller), std::chrono::milliseconds(-1));
+
+  uint64_t const one = 1;
+  for (int n = 0; n < Writes; ++n)
+    for (int fd : fds)
+      ASSERT_EQ(ssize_t(sizeof(one)), ::write(fd, &one, sizeof(one)));
+  auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (total < uint64_t(Fds * Writes) && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  poller.quit_loop();
+  loop.join();
+  poller.join();
+  EXPECT_EQ(uint64_t(Fds * Writes), total.load());
+  EXPECT_TRUE(same_thread);
+  for (int fd : fds)
+    ::close(fd);
+}
+
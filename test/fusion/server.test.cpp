@@ -0,0 +1,78 @@
+#include <utest.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ku/fusion/tcp/server.hpp>
+
+using namespace ku::fusion;
+
+namespace {
+
+class EchoHandler
+{
+public:
+  bool handle_inbound(SocketConnection& connection)
+  {
+    char buf[256];
+    ssize_t size = connection.socket().read(buf, sizeof(buf));
+    if (size > 0)
+      connection.socket().write(buf, size);
+    return true;
+  }
+};
+
+} // unamed namespace
+
+TEST(TcpServer, reuse_port)
+{
+  sockaddr_in addr = sockaddr_in();
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  tcp::Server<EchoHandler> server(SocketEndpoint(addr), 2, true);
+  EXPECT_EQ(2u, server.loops());
+  uint16_t const port = server.local_endpoint().port();
+  ASSERT_NE(0, port);
+
+  std::thread t(std::ref(server));
+  std::vector<int> clients;
+  addr.sin_port = ::htons(port);
+  for (int n = 0; n < 8; ++n) {
+    int const client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_LE(0, client);
+    ASSERT_EQ(0, ::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+    clients.push_back(client);
+  }
+  for (size_t n = 0; n < clients.size(); ++n) {
+    std::string const msg = "hello " + std::to_string(n);
+    ASSERT_EQ(ssize_t(msg.size()), ::write(clients[n], msg.data(), msg.size()));
+    char buf[256];
+    ssize_t const size = ::read(clients[n], buf, sizeof(buf));
+    ASSERT_EQ(ssize_t(msg.size()), size);
+    EXPECT_EQ(msg, std::string(buf, size));
+  }
+  for (int client : clients)
+    ::close(client);
+
+  server.stop();
+  t.join();
+}
+
+TEST(TcpServer, unpins_caller)
+{
+  sockaddr_in addr = sockaddr_in();
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+  std::vector<int> const cpus = util::cpu_affinity();
+  ASSERT_FALSE(cpus.empty());
+  tcp::Server<EchoHandler> server(SocketEndpoint(addr), 2, true);
+  std::thread t([&server]() { std::this_thread::sleep_for(std::chrono::milliseconds(10)); server.stop(); });
+  server();
+  t.join();
+  EXPECT_EQ(cpus, util::cpu_affinity());
+}
@@ -0,0 +1,83 @@
+#include <utest.hpp>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <ku/log/log_index.hpp>
+
+using namespace ku::log;
+
+namespace {
+
+std::string const LogFile = "/tmp/ku_log_index_test.log";
+
+void write_block(int fd, IndexWriter& writer, uint64_t& offset, std::string const& data,
+                 uint64_t time, LogLevel level)
+{
+  ::write(fd, data.data(), data.size());
+  WriteInfo info;
+  info.add(level, time);
+  writer.add(offset, data.size(), info);
+  offset += data.size();
+}
+
+} // unamed namespace
+
+TEST(LogIndex, write_read)
+{
+  int fd = ::open(LogFile.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+  ASSERT_NE(-1, fd);
+  uint64_t offset = 0;
+  {
+    IndexWriter writer;
+    writer.set_interval(8);
+    writer.open(index_file_name(LogFile));
+    write_block(fd, writer, offset, "block a\n", 100, LogLevel::Debug);
+    write_block(fd, writer, offset, "block b\n", 200, LogLevel::Warn);
+    write_block(fd, writer, offset, "block c\n", 300, LogLevel::Info);
+    write_block(fd, writer, offset, "tail", 400, LogLevel::Info); // pending until close
+  }
+  ::write(fd, "unindexed\n", 10);
+  ::close(fd);
+
+  IndexReader reader(LogFile);
+  EXPECT_EQ(4, reader.end() - reader.begin());
+  EXPECT_EQ(28u, reader.indexed_size());
+
+  std::vector<std::string> blocks;
+  auto collect = [&](char const* p, size_t size) { blocks.emplace_back(p, size); };
+  reader.for_each_block(150, 300, ~0u, collect);
+  ASSERT_EQ(3u, blocks.size());
+  EXPECT_EQ("block b\n", blocks[0]);
+  EXPECT_EQ("block c\n", blocks[1]);
+  EXPECT_EQ("unindexed\n", blocks[2]);
+
+  blocks.clear();
+  reader.for_each_block(0, 1000, 1u << static_cast<uint32_t>(LogLevel::Warn), collect);
+  ASSERT_EQ(2u, blocks.size());
+  EXPECT_EQ("block b\n", blocks[0]);
+
+  ::unlink(LogFile.c_str());
+  ::unlink(index_file_name(LogFile).c_str());
+}
+
+TEST(LogLevel, to_log_level)
+{
+  LogLevel level;
+  EXPECT_TRUE(to_log_level(" Info  ", 7, level));
+  EXPECT_EQ(LogLevel::Info, level);
+  EXPECT_TRUE(to_log_level("Fatal", 5, level));
+  EXPECT_EQ(LogLevel::Fatal, level);
+  EXPECT_FALSE(to_log_level("Inf", 3, level));
+  EXPECT_FALSE(to_log_level("", 0, level));
+}
+
+TEST(Util, parse_time)
+{
+  char buf[32];
+  uint64_t time;
+  ASSERT_TRUE(util::parse_time("2011-12-08 10:31:05.25", time));
+  EXPECT_EQ(250000000u, time % 1000000000u);
+  EXPECT_EQ("2011-12-08 10:31:05.250000000", std::string(buf, util::format_time(buf, time)));
+  EXPECT_FALSE(util::parse_time("10:31:05", time));
+}
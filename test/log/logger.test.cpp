@@ -0,0 +1,39 @@
+#include <utest.hpp>
+#include <sched.h>
+#include <string>
+#include <vector>
+#include <ku/log/logger.hpp>
+
+using namespace ku::log;
+
+TEST(Logger, writer_placement)
+{
+  Logger logger("placement");
+  EXPECT_NO_THROW(logger.set_cpu_affinity({ 0 }));
+  EXPECT_NO_THROW(logger.set_scheduling(SCHED_OTHER));
+  EXPECT_NO_THROW(logger.set_nice(5));
+  EXPECT_THROW(logger.set_scheduling(SCHED_OTHER, 10), std::system_error);
+}
+
+TEST(Logger, numa_node)
+{
+  EXPECT_LE(1u, util::numa_node_count());
+  EXPECT_GT(util::numa_node_count(), util::numa_node());
+}
+
+TEST(MessageQueue, split_by_node)
+{
+  BufferList free_queue;
+  MessageQueue queue;
+  Message m0(LogLevel::Info, free_queue, 0), m1(LogLevel::Info, free_queue, 1);
+  m0.append("node 0", 6);
+  m1.append(std::string(300, '1').c_str(), 300); // 2 nodes
+  queue.emplace_back(std::move(m0));
+  queue.emplace_back(std::move(m1));
+
+  std::vector<BufferList> lists(2);
+  queue.split_by_node(lists);
+  EXPECT_EQ(0u, queue.buffers().raw_buffer_count());
+  EXPECT_EQ(1u, lists[0].raw_buffer_count());
+  EXPECT_EQ(2u, lists[1].raw_buffer_count());
+}
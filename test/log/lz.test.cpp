@@ -0,0 +1,101 @@
+#include <utest.hpp>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+#include <ku/log/lz.hpp>
+#include <ku/log/compress_sink.hpp>
+#include <ku/log/log.hpp>
+
+using namespace ku::log;
+
+namespace {
+
+struct StringSink : public Sink
+{
+  StringSink(std::string& out) : Sink(LogLevel::Debug), out(out) { }
+
+  virtual void write(BufferList const& list)
+  {
+    iovec const* p = list.raw_buffer();
+    for (uint32_t n = 0; n < list.raw_buffer_count(); ++n)
+      out.append(static_cast<char const*>(p[n].iov_base), p[n].iov_len);
+  }
+
+  std::string& out;
+};
+
+std::string roundtrip(std::string const& in)
+{
+  std::vector<char> frame(lz::frame_bound(in.size()));
+  size_t size = lz::encode_frame(in.data(), in.size(), frame.data());
+  std::string out;
+  EXPECT_EQ(size, lz::decode_frame(frame.data(), size, out));
+  return out;
+}
+
+} // unamed namespace
+
+TEST(Lz, roundtrip)
+{
+  std::string lines;
+  for (int n = 0; n < 1000; ++n)
+    lines += "2011-12-08 10:31:05.000000042 Info   order " + std::to_string(n * 7919) + " accepted\n";
+  EXPECT_EQ(lines, roundtrip(lines));
+  EXPECT_EQ(std::string(), roundtrip(std::string()));
+  EXPECT_EQ(std::string("abc"), roundtrip("abc"));
+  EXPECT_EQ(std::string(300, 'a'), roundtrip(std::string(300, 'a')));
+
+  std::string noise;
+  uint32_t x = 42;
+  for (int n = 0; n < 4096; ++n, x = x * 1103515245 + 12345)
+    noise += static_cast<char>(x >> 24);
+  EXPECT_EQ(noise, roundtrip(noise));
+
+  std::vector<char> frame(lz::frame_bound(lines.size()));
+  EXPECT_LT(lz::encode_frame(lines.data(), lines.size(), frame.data()), lines.size() / 3);
+}
+
+TEST(Lz, corruption)
+{
+  std::string lines(1000, 'x');
+  std::vector<char> frame(lz::frame_bound(lines.size()));
+  size_t size = lz::encode_frame(lines.data(), lines.size(), frame.data());
+  std::string out;
+  EXPECT_EQ(0u, lz::decode_frame(frame.data(), size - 1, out));
+  frame[size - 1] ^= 1;
+  EXPECT_EQ(0u, lz::decode_frame(frame.data(), size, out));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(frame.data() + size, lz::find_frame(frame.data(), size));
+}
+
+TEST(Lz, compress_sink)
+{
+  std::string out;
+  {
+    Logger logger;
+    CompressSink* sink = new CompressSink(Sink_ptr(new StringSink(out)));
+    logger.add_sink(Sink_ptr(sink));
+    for (int n = 0; n < 100; ++n)
+      LOG_TO(logger, Info) << "compressed " << n;
+  }
+  ASSERT_FALSE(out.empty());
+
+  // Decoding from any frame boundary
+  std::string text;
+  char const* p = out.data();
+  char const* const end = p + out.size();
+  std::vector<char const*> frames;
+  while (p < end) {
+    frames.push_back(p);
+    size_t n = lz::decode_frame(p, end - p, text);
+    ASSERT_NE(0u, n);
+    p += n;
+  }
+  for (int n = 0; n < 100; ++n)
+    EXPECT_NE(std::string::npos, text.find("compressed " + std::to_string(n) + "\n"));
+
+  std::string tail;
+  lz::decode_frame(frames.back(), end - frames.back(), tail);
+  EXPECT_EQ(text.substr(text.size() - tail.size()), tail);
+  EXPECT_EQ(frames.front(), lz::find_frame(out.data(), out.size()));
+}
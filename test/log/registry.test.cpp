@@ -0,0 +1,55 @@
+#include <utest.hpp>
+#include <sys/uio.h>
+#include <string>
+#include <ku/log/log.hpp>
+
+using namespace ku::log;
+
+struct StringSink : public Sink
+{
+  StringSink(std::string& out) : Sink(LogLevel::Debug), out(out) { }
+
+  virtual void write(BufferList const& list)
+  {
+    iovec const* p = list.raw_buffer();
+    for (uint32_t n = 0; n < list.raw_buffer_count(); ++n)
+      out.append(static_cast<char const*>(p[n].iov_base), p[n].iov_len);
+  }
+
+  std::string& out;
+};
+
+TEST(Registry, get_find_remove)
+{
+  Registry registry;
+  EXPECT_EQ(nullptr, registry.find("audit"));
+  Logger& audit = registry.get("audit");
+  EXPECT_EQ("audit", audit.name());
+  EXPECT_EQ(&audit, &registry.get("audit"));
+  EXPECT_EQ(&audit, registry.find("audit"));
+  EXPECT_NE(&audit, &registry.get("journal"));
+  EXPECT_TRUE(registry.remove("audit"));
+  EXPECT_FALSE(registry.remove("audit"));
+  EXPECT_EQ(nullptr, registry.find("audit"));
+}
+
+TEST(Registry, log_to)
+{
+  std::string audit_out, journal_out;
+  {
+    Registry registry;
+    Logger& audit = registry.get("audit");
+    Logger& journal = registry.get("journal");
+    audit.add_sink(Sink_ptr(new StringSink(audit_out)));
+    journal.add_sink(Sink_ptr(new StringSink(journal_out)));
+    journal.set_log_level(LogLevel::Info);
+
+    LOG_TO(audit, Info) << "to audit";
+    LOG_TO(journal, Debug) << "filtered";
+    LOG_TO_IF(journal, Warn, true) << "to journal";
+  } // loggers flush on destruction
+  EXPECT_NE(std::string::npos, audit_out.find("to audit"));
+  EXPECT_EQ(std::string::npos, audit_out.find("to journal"));
+  EXPECT_NE(std::string::npos, journal_out.find("to journal"));
+  EXPECT_EQ(std::string::npos, journal_out.find("filtered"));
+}
@@ -0,0 +1,90 @@
+#include <utest.hpp>
+#include <sys/uio.h>
+#include <string>
+#include <ku/log/field.hpp>
+#include <ku/log/render.hpp>
+#include <ku/log/log.hpp>
+
+using namespace ku::log;
+
+namespace {
+
+std::string const Header = "2011-12-08 10:31:05.000000042 Info  ";
+
+std::string collect(Buffer& buf)
+{
+  buf.append('\n');
+  return to_str(buf);
+}
+
+std::string render_str(Format format, std::string const& message, uint32_t field_count)
+{
+  Buffer out;
+  render(format, message.data(), message.size(), field_count, out);
+  return to_str(out);
+}
+
+} // unamed namespace
+
+TEST(Render, fields)
+{
+  Buffer buf;
+  buf.append(Header.data(), Header.size());
+  buf.append("order accepted", 14);
+  append_field(buf, "order_id", 42u);
+  append_field(buf, "px", 1.25);
+  append_field(buf, "qty", -3);
+  append_field(buf, "side", "buy");
+  append_field(buf, "ioc", true);
+  std::string message = collect(buf);
+
+  EXPECT_EQ(Header + "order accepted order_id=42 px=1.25 qty=-3 side=buy ioc=true\n",
+            render_str(Format::Text, message, 5));
+  EXPECT_EQ("ts=\"2011-12-08 10:31:05.000000042\" level=Info msg=\"order accepted\" "
+            "order_id=42 px=1.25 qty=-3 side=buy ioc=true\n",
+            render_str(Format::Logfmt, message, 5));
+  EXPECT_EQ("{\"ts\":\"2011-12-08 10:31:05.000000042\",\"level\":\"Info\",\"msg\":\"order accepted\","
+            "\"order_id\":42,\"px\":1.25,\"qty\":-3,\"side\":\"buy\",\"ioc\":true}\n",
+            render_str(Format::Json, message, 5));
+}
+
+TEST(Render, plain_text)
+{
+  std::string message = Header + "say \"hi\"\n";
+  EXPECT_EQ(message, render_str(Format::Text, message, 0));
+  EXPECT_EQ("{\"ts\":\"2011-12-08 10:31:05.000000042\",\"level\":\"Info\",\"msg\":\"say \\\"hi\\\"\"}\n",
+            render_str(Format::Json, message, 0));
+}
+
+TEST(Render, long_string_field)
+{
+  Buffer buf;
+  buf.append(Header.data(), Header.size());
+  std::string value(600, 'x'); // spans several buffer nodes
+  append_field(buf, "blob", value);
+  EXPECT_EQ(Header + " blob=" + value + "\n", render_str(Format::Text, collect(buf), 1));
+}
+
+TEST(Render, logger)
+{
+  struct JsonSink : public Sink
+  {
+    JsonSink(std::string& out) : Sink(LogLevel::Debug, Format::Json), out(out) { }
+    virtual void write(BufferList const& list)
+    {
+      iovec const* p = list.raw_buffer();
+      for (uint32_t n = 0; n < list.raw_buffer_count(); ++n)
+        out.append(static_cast<char const*>(p[n].iov_base), p[n].iov_len);
+    }
+    std::string& out;
+  };
+
+  std::string out;
+  {
+    Logger logger("render");
+    logger.add_sink(Sink_ptr(new JsonSink(out)));
+    LOG_TO(logger, Warn).kv("order_id", 7).kv("px", 99.5) << "rejected";
+  }
+  EXPECT_NE(std::string::npos,
+            out.find("\"level\":\"Warn\",\"msg\":\"rejected\",\"order_id\":7,\"px\":99.5}\n"));
+}